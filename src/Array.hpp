@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <new>
+#include "common.hpp"
+
+constexpr size_t ARRAY_ALIGNMENT = 64; // a cache line, which is also enough for the widest SIMD loads
+
+template<typename T> struct AlignedAllocator
+{
+	using value_type = T;
+
+	AlignedAllocator() = default;
+	template<typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+	T* allocate(size_t count)
+	{
+		return (T*)::operator new(count * sizeof(T), std::align_val_t(ARRAY_ALIGNMENT));
+	}
+
+	void deallocate(T* pointer, size_t)
+	{
+		::operator delete(pointer, std::align_val_t(ARRAY_ALIGNMENT));
+	}
+
+	template<typename U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+	template<typename U> bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+template<typename T> using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// the elements of an int[] or a float[], stored next to each other so that they can be processed with SIMD instructions
+// only the vector of the element type is used
+struct Array
+{
+	Array(DataType elementType, size_t size = 0) : elementType(elementType)
+	{
+		if (elementType == DATA_TYPE_INT)
+			ints.resize(size);
+		else
+			floats.resize(size);
+	}
+
+	size_t Size() const
+	{
+		return elementType == DATA_TYPE_INT ? ints.size() : floats.size();
+	}
+
+	DataType elementType;
+	AlignedVector<int> ints;
+	AlignedVector<float> floats;
+};
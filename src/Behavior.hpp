@@ -16,24 +16,39 @@ enum Args
 	ARG_INPUT,
 	ARG_REMOVE_UNUSED_SYMBOLS,
 	ARG_OPTIMIZE_INSTRUCTIONS,
-	ARG_PARSE_MULTITHREADED, // reserved
+	ARG_PARSE_MULTITHREADED,
+	ARG_BYTECODE_CACHE,
+	ARG_CACHE_DIRECTORY,
+	ARG_OUTPUT_BUFFERING,
 };
 
-namespace Behavior
+enum OutputBuffering
 {
-	inline bool verbose = false;
-	inline bool dumpFunctionInstructions = false;
-	inline bool dumpStackFrame = false;
-	inline bool dumpTokens = false;
-	inline bool treatVoidAsError = false;
-	inline bool disableImplicitConversion = false;
-	inline bool removeUnusedSymbols = false;
-	inline bool optimizeInstructions = false;
+	OUTPUT_BUFFERING_AUTO, // line buffered when writing to a terminal, fully buffered otherwise
+	OUTPUT_BUFFERING_LINE,
+	OUTPUT_BUFFERING_FULL,
+};
+
+// the command arguments, every ScriptContext has its own copy so that scripts in one process can run with different ones
+struct Behavior
+{
+	bool verbose = false;
+	bool dumpFunctionInstructions = false;
+	bool dumpStackFrame = false;
+	bool dumpTokens = false;
+	bool treatVoidAsError = false;
+	bool disableImplicitConversion = false;
+	bool removeUnusedSymbols = false;
+	bool optimizeInstructions = false;
+	bool parseMultithreaded = false;
+	bool bytecodeCache = false;
+	OutputBuffering outputBuffering = OUTPUT_BUFFERING_AUTO;
 
-	inline std::string input = "";
-	inline std::string entryPoint = "main";
+	std::string input = "";
+	std::string entryPoint = "main";
+	std::string cacheDirectory = ""; // an empty directory means that the cache is written next to the input file
 
-	inline void ProcessCommandArguments(int argc, const char** argv)
+	void ProcessCommandArguments(int argc, const char** argv)
 	{
 		static std::unordered_map<std::string, Args> stringToArgs =
 		{
@@ -41,7 +56,8 @@ namespace Behavior
 			{ "-input",   ARG_INPUT   }, { "-dump_stack_frames", ARG_DUMP_STACK_FRAMES }, { "-treat_void_as_error", ARG_TREAT_VOID_AS_ERROR },
 			{ "-remove_unused_symbols", ARG_REMOVE_UNUSED_SYMBOLS }, {"-disable_implicit_conversion", ARG_DISABLE_IMPLICIT_CONVERSION},
 			{ "-optimize_instructions", ARG_OPTIMIZE_INSTRUCTIONS }, { "-parse_multithreaded", ARG_PARSE_MULTITHREADED },
-			{ "-dump_tokens", ARG_DUMP_TOKENS },
+			{ "-dump_tokens", ARG_DUMP_TOKENS }, { "-bytecode_cache", ARG_BYTECODE_CACHE }, { "-cache_directory", ARG_CACHE_DIRECTORY },
+			{ "-output_buffering", ARG_OUTPUT_BUFFERING },
 		};
 		for (int i = 0; i < argc; i++)
 		{
@@ -51,6 +67,8 @@ namespace Behavior
 
 			switch (stringToArgs[arg])
 			{
+			case ARG_NONE:
+				break;
 			case ARG_VERBOSE:
 				verbose = true;
 				break;
@@ -80,9 +98,29 @@ namespace Behavior
 			case ARG_OPTIMIZE_INSTRUCTIONS:
 				optimizeInstructions = true;
 				break;
+			case ARG_PARSE_MULTITHREADED:
+				parseMultithreaded = true;
+				break;
 			case ARG_DUMP_TOKENS:
 				dumpTokens = true;
 				break;
+			case ARG_BYTECODE_CACHE:
+				bytecodeCache = true;
+				break;
+			case ARG_CACHE_DIRECTORY:
+				bytecodeCache = true;
+				cacheDirectory = argv[i + 1];
+				i++;
+				break;
+			case ARG_OUTPUT_BUFFERING:
+				if (std::string(argv[i + 1]) == "line")
+					outputBuffering = OUTPUT_BUFFERING_LINE;
+				else if (std::string(argv[i + 1]) == "full")
+					outputBuffering = OUTPUT_BUFFERING_FULL;
+				else
+					std::cerr << "Unknown output buffering " << argv[i + 1] << ", expected \"line\" or \"full\"\n";
+				i++;
+				break;
 			}
 		}
 		if (!verbose)
@@ -98,4 +136,4 @@ namespace Behavior
 		}
 		std::cout << "\n\n";
 	}
-}
\ No newline at end of file
+};
@@ -0,0 +1,320 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <unordered_map>
+#include <cstring>
+#include "BytecodeCache.hpp"
+#include "MappedFile.hpp"
+#include "Interpreter.hpp"
+#include "Behavior.hpp"
+
+constexpr char CACHE_MAGIC[4] = { 'S', 'C', 'R', 'C' };
+constexpr uint32_t CACHE_FORMAT_VERSION = 3; // has to be increased whenever the layout below, the meaning of an existing instruction or the numbering of the data types changes
+constexpr uint32_t INSTRUCTION_TYPE_COUNT = INSTRUCTION_TYPE_YIELD + 1; // has to be changed to the last instruction type whenever one is added
+
+// the file starts with the header, followed by the imports, the symbol table, the constant pool and the functions
+// strings are stored as their length followed by their characters, so nothing after the header is aligned and every value is copied out
+struct CacheHeader
+{
+	char magic[4];
+	uint32_t formatVersion;
+	uint32_t instructionTypeCount; // a cache written before an instruction was added is never valid
+	uint32_t firstUserSymbol;      // reserved symbols are stored as is, so they have to be numbered the same way
+	uint64_t inputHash;
+	uint32_t importCount;          // every import is its content hash and its path
+	uint32_t symbolCount;          // the names of the user symbols, the first one is stored as firstUserSymbol
+	uint32_t constantCount;        // the literal values, a constant of 0 means that there is no literal
+	uint32_t functionCount;
+	uint32_t compileFlags;         // the command arguments that change how functions are compiled
+};
+
+struct CachedVariableInfo
+{
+	uint32_t name;
+	uint32_t dataType;
+	uint32_t size;
+	uint32_t constant;
+};
+
+struct CachedInstruction
+{
+	uint32_t type;
+	CachedVariableInfo operand1;
+	CachedVariableInfo operand2;
+};
+
+struct CachedFunction // followed by its parameters and its instructions
+{
+	uint32_t name;
+	uint32_t returnType;
+	uint32_t parameterCount;
+	uint32_t instructionCount;
+	uint64_t signatureHash;
+	uint64_t bodyHash;
+	uint64_t dependencyHash;
+};
+
+inline uint32_t GetCompileFlags(const Behavior& behavior)
+{
+	return (uint32_t)behavior.disableImplicitConversion;
+}
+
+inline uint64_t HashFile(const std::string& path)
+{
+	MappedFile file(path);
+	return HashContent(file.View());
+}
+
+inline std::string GetCachePath(const Behavior& behavior, const std::string& inputPath)
+{
+	if (behavior.cacheDirectory.empty())
+		return std::filesystem::path(inputPath).replace_extension(".scriptc").string();
+
+	// the name only depends on where the input is, so that an outdated cache of the same input is found again and its unchanged functions can be reused
+	uint64_t pathHash = HashContent(std::filesystem::absolute(inputPath).lexically_normal().generic_string());
+	constexpr char digits[] = "0123456789abcdef";
+	std::string name(16, '0');
+	for (int i = 15; i >= 0; i--, pathHash >>= 4)
+		name[i] = digits[pathHash & 0xF];
+	return (std::filesystem::path(behavior.cacheDirectory) / (name + ".scriptc")).string();
+}
+
+class CacheWriter
+{
+public:
+	template<typename T> void Write(const T& value)
+	{
+		buffer.append((const char*)&value, sizeof(T));
+	}
+
+	void WriteString(std::string_view string)
+	{
+		Write((uint32_t)string.size());
+		buffer.append(string);
+	}
+
+	uint32_t AddSymbol(Symbol symbol)
+	{
+		if (symbol < SYMBOL_FIRST_USER_SYMBOL)
+			return symbol;
+		auto [it, inserted] = symbolIndices.try_emplace(symbol, (uint32_t)symbols.size());
+		if (inserted)
+			symbols.push_back(symbol);
+		return SYMBOL_FIRST_USER_SYMBOL + it->second;
+	}
+
+	uint32_t AddConstant(const std::string& constant)
+	{
+		if (constant.empty())
+			return 0;
+		auto [it, inserted] = constantIndices.try_emplace(constant, (uint32_t)constants.size() + 1);
+		if (inserted)
+			constants.push_back(&it->first);
+		return it->second;
+	}
+
+	CachedVariableInfo AddVariableInfo(const VariableInfo& info)
+	{
+		return { AddSymbol(info.name), (uint32_t)info.dataType, info.size, AddConstant(info.literalValue) };
+	}
+
+	std::string buffer;
+	std::vector<Symbol> symbols;
+	std::vector<const std::string*> constants;
+
+private:
+	std::unordered_map<Symbol, uint32_t> symbolIndices;
+	std::unordered_map<std::string, uint32_t> constantIndices;
+};
+
+class CacheReader // any read outside of the file throws, so a truncated cache is treated like an outdated one
+{
+public:
+	CacheReader(std::string_view data) : data(data) {}
+
+	template<typename T> T Read()
+	{
+		if (data.size() - offset < sizeof(T))
+			throw std::runtime_error("unexpected end of file");
+		T ret;
+		memcpy(&ret, data.data() + offset, sizeof(T));
+		offset += sizeof(T);
+		return ret;
+	}
+
+	std::string_view ReadString()
+	{
+		uint32_t length = Read<uint32_t>();
+		if (data.size() - offset < length)
+			throw std::runtime_error("unexpected end of file");
+		offset += length;
+		return data.substr(offset - length, length);
+	}
+
+	VariableInfo ReadVariableInfo()
+	{
+		return ToVariableInfo(Read<CachedVariableInfo>());
+	}
+
+	VariableInfo ToVariableInfo(const CachedVariableInfo& info)
+	{
+		if (info.name >= SYMBOL_FIRST_USER_SYMBOL + symbols.size() || info.constant > constants.size())
+			throw std::runtime_error("invalid symbol or constant");
+		VariableInfo ret{};
+		ret.name = info.name < SYMBOL_FIRST_USER_SYMBOL ? info.name : symbols[info.name - SYMBOL_FIRST_USER_SYMBOL];
+		ret.dataType = (DataType)info.dataType;
+		ret.size = info.size;
+		if (info.constant != 0)
+			ret.literalValue = constants[info.constant - 1];
+		return ret;
+	}
+
+	std::vector<Symbol> symbols; // the symbols of this run, indexed by the user symbols of the file
+	std::vector<std::string_view> constants;
+
+private:
+	std::string_view data;
+	size_t offset = 0;
+};
+
+inline bool IsHeaderValid(const Behavior& behavior, const CacheHeader& header) // a cache with a valid header can be out of date, but its functions can still be reused
+{
+	return memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 && header.formatVersion == CACHE_FORMAT_VERSION && header.instructionTypeCount == INSTRUCTION_TYPE_COUNT
+		&& header.firstUserSymbol == SYMBOL_FIRST_USER_SYMBOL && header.compileFlags == GetCompileFlags(behavior);
+}
+
+bool BytecodeCache::Load(const Behavior& behavior, const std::string& inputPath, std::string_view input, std::vector<FunctionInfo>& functions, std::vector<std::string>& importedFiles)
+{
+	uint64_t inputHash = HashContent(input);
+	std::string cachePath = GetCachePath(behavior, inputPath);
+	if (!std::filesystem::exists(cachePath))
+		return false;
+
+	try
+	{
+		MappedFile cache(cachePath);
+		CacheReader reader(cache.View());
+		CacheHeader header = reader.Read<CacheHeader>();
+		if (!IsHeaderValid(behavior, header))
+			throw std::runtime_error("it was written by another interpreter version or with other command arguments");
+
+		std::string outdatedReason = header.inputHash == inputHash ? "" : "the input changed";
+		std::vector<std::string> imports;
+		for (uint32_t i = 0; i < header.importCount; i++)
+		{
+			uint64_t importHash = reader.Read<uint64_t>();
+			imports.emplace_back(reader.ReadString());
+			if (outdatedReason.empty() && (!std::filesystem::exists(imports.back()) || HashFile(imports.back()) != importHash))
+				outdatedReason = "imported file " + imports.back() + " changed";
+		}
+
+		for (uint32_t i = 0; i < header.symbolCount; i++)
+			reader.symbols.push_back(SymbolTable::Intern(reader.ReadString()));
+		for (uint32_t i = 0; i < header.constantCount; i++)
+			reader.constants.push_back(reader.ReadString());
+
+		std::vector<FunctionInfo> ret(header.functionCount);
+		for (FunctionInfo& info : ret)
+		{
+			CachedFunction function = reader.Read<CachedFunction>();
+			info.name = reader.ToVariableInfo({ function.name, DATA_TYPE_VOID, 0, 0 }).name;
+			info.returnType = (DataType)function.returnType;
+			info.signatureHash = function.signatureHash;
+			info.bodyHash = function.bodyHash;
+			info.dependencyHash = function.dependencyHash;
+			for (uint32_t i = 0; i < function.parameterCount; i++)
+				info.parameters.push_back(reader.ReadVariableInfo());
+
+			info.instructions.resize(function.instructionCount);
+			for (Instruction& instruction : info.instructions)
+			{
+				CachedInstruction cached = reader.Read<CachedInstruction>();
+				instruction.type = (InstructionType)cached.type;
+				instruction.operand1 = reader.ToVariableInfo(cached.operand1);
+				instruction.operand2 = reader.ToVariableInfo(cached.operand2);
+			}
+		}
+
+		functions = std::move(ret);
+		if (!outdatedReason.empty())
+		{
+			if (behavior.verbose)
+				std::cout << "The bytecode cache at " << cachePath << " is out of date (" << outdatedReason << "), only the functions that did not change are reused\n";
+			return false;
+		}
+
+		importedFiles.insert(importedFiles.end(), imports.begin(), imports.end());
+		if (behavior.verbose)
+			std::cout << "Loaded " << functions.size() << " functions from the bytecode cache at " << cachePath << "\n";
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		if (behavior.verbose)
+			std::cout << "Ignoring the bytecode cache at " << cachePath << ": " << ex.what() << "\n";
+		return false;
+	}
+}
+
+void BytecodeCache::Save(const Behavior& behavior, const std::string& inputPath, std::string_view input, const std::vector<FunctionInfo>& functions, const std::vector<std::string>& importedFiles)
+{
+	uint64_t inputHash = HashContent(input);
+	std::string cachePath = GetCachePath(behavior, inputPath);
+
+	CacheWriter body; // the symbols and constants are only known after every function has been written, so they are put in front of it afterwards
+	for (const FunctionInfo& info : functions)
+	{
+		body.Write(CachedFunction{ body.AddSymbol(info.name), (uint32_t)info.returnType, (uint32_t)info.parameters.size(), (uint32_t)info.instructions.size(), info.signatureHash, info.bodyHash, info.dependencyHash });
+		for (const VariableInfo& parameter : info.parameters)
+			body.Write(body.AddVariableInfo(parameter));
+		for (const Instruction& instruction : info.instructions)
+			body.Write(CachedInstruction{ (uint32_t)instruction.type, body.AddVariableInfo(instruction.operand1), body.AddVariableInfo(instruction.operand2) });
+	}
+
+	CacheHeader header{};
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.formatVersion = CACHE_FORMAT_VERSION;
+	header.instructionTypeCount = INSTRUCTION_TYPE_COUNT;
+	header.firstUserSymbol = SYMBOL_FIRST_USER_SYMBOL;
+	header.inputHash = inputHash;
+	header.importCount = (uint32_t)importedFiles.size();
+	header.symbolCount = (uint32_t)body.symbols.size();
+	header.constantCount = (uint32_t)body.constants.size();
+	header.functionCount = (uint32_t)functions.size();
+	header.compileFlags = GetCompileFlags(behavior);
+
+	try
+	{
+		CacheWriter file;
+		file.Write(header);
+		for (const std::string& import : importedFiles)
+		{
+			file.Write(HashFile(import));
+			file.WriteString(import);
+		}
+		for (Symbol symbol : body.symbols)
+			file.WriteString(SymbolTable::GetName(symbol));
+		for (const std::string* constant : body.constants)
+			file.WriteString(*constant);
+		file.buffer += body.buffer;
+
+		if (!behavior.cacheDirectory.empty())
+			std::filesystem::create_directories(behavior.cacheDirectory);
+
+		std::string temporaryPath = cachePath + ".tmp"; // renaming a finished file prevents another run from mapping a half written cache
+		{
+			std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+			stream.write(file.buffer.data(), (std::streamsize)file.buffer.size());
+			if (!stream)
+				throw std::runtime_error("could not write " + temporaryPath);
+		}
+		std::filesystem::rename(temporaryPath, cachePath);
+
+		if (behavior.verbose)
+			std::cout << "Wrote " << functions.size() << " functions to the bytecode cache at " << cachePath << "\n";
+	}
+	catch (std::exception& ex) // the cache only speeds up the next run, failing to write it should not stop this one
+	{
+		std::cerr << "Failed to write the bytecode cache at " << cachePath << ": " << ex.what() << "\n";
+	}
+}
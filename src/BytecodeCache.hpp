@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Function.hpp"
+#include "Behavior.hpp"
+
+// compiled functions are written to a binary .scriptc file, so that later runs can start executing without touching the lexer or parser
+// a cache is only used if the input and every file it imports still hash to the same values as when the cache was written
+namespace BytecodeCache
+{
+	// returns false if there is no usable cache for the input, on success the files that the input imported are added to importedFiles
+	// a cache that is only out of date still fills functions, the ones that did not change can be reused by the parser
+	inline extern bool Load(const Behavior& behavior, const std::string& inputPath, std::string_view input, std::vector<FunctionInfo>& functions, std::vector<std::string>& importedFiles);
+	// every function has to be compiled and importedFiles has to contain every file that the input imported
+	inline extern void Save(const Behavior& behavior, const std::string& inputPath, std::string_view input, const std::vector<FunctionInfo>& functions, const std::vector<std::string>& importedFiles);
+}
@@ -0,0 +1,237 @@
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "Channel.hpp"
+#include "ScriptContext.hpp"
+#include "Parallel.hpp"
+
+constexpr size_t CHANNEL_SPIN_COUNT = 1 << 10; // attempts before a waiting thread sleeps, it yields its core for the second half of them
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+inline size_t GetChannelSize(size_t capacity) // a power of 2, so that a position becomes an index with a mask
+{
+	size_t ret = 2;
+	while (ret < capacity)
+		ret <<= 1;
+	return ret;
+}
+
+// the producer and the consumer each own one position and only read the other one when the copy they keep of it says that the channel is full or empty
+struct SingleProducerChannel : Channel
+{
+	SingleProducerChannel(size_t capacity) : values(GetChannelSize(capacity)), mask(values.size() - 1) {}
+
+	bool TrySend(const Variable& value) override
+	{
+		size_t position = sendPosition.load(std::memory_order_relaxed);
+		if (position - knownReceivePosition == values.size())
+		{
+			knownReceivePosition = receivePosition.load(std::memory_order_acquire);
+			if (position - knownReceivePosition == values.size())
+				return false;
+		}
+		values[position & mask] = value;
+		sendPosition.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool TryReceive(Variable& value) override
+	{
+		size_t position = receivePosition.load(std::memory_order_relaxed);
+		if (position == knownSendPosition)
+		{
+			knownSendPosition = sendPosition.load(std::memory_order_acquire);
+			if (position == knownSendPosition)
+				return false;
+		}
+		value = values[position & mask];
+		values[position & mask] = Variable(); // an array that was sent should not be kept alive by the channel
+		receivePosition.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	std::vector<Variable> values;
+	size_t mask;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> sendPosition = 0;
+	size_t knownReceivePosition = 0; // only used by the producer
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> receivePosition = 0;
+	size_t knownSendPosition = 0;    // only used by the consumer
+};
+
+// every cell has a sequence number that says whether it is free for the sender or filled for the receiver of a position, threads claim a position by advancing it
+struct MultiProducerChannel : Channel
+{
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		Variable value;
+	};
+
+	MultiProducerChannel(size_t capacity) : cells(GetChannelSize(capacity)), mask(cells.size() - 1)
+	{
+		for (size_t i = 0; i < cells.size(); i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	bool TrySend(const Variable& value) override
+	{
+		size_t position = sendPosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = cells[position & mask];
+			intptr_t difference = (intptr_t)cell.sequence.load(std::memory_order_acquire) - (intptr_t)position;
+			if (difference < 0) // the receiver of the position one round earlier has not taken its value yet
+				return false;
+			if (difference > 0) // another sender claimed the position first
+				position = sendPosition.load(std::memory_order_relaxed);
+			else if (sendPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				cell.value = value;
+				cell.sequence.store(position + 1, std::memory_order_release);
+				return true;
+			}
+		}
+	}
+
+	bool TryReceive(Variable& value) override
+	{
+		size_t position = receivePosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = cells[position & mask];
+			intptr_t difference = (intptr_t)cell.sequence.load(std::memory_order_acquire) - (intptr_t)(position + 1);
+			if (difference < 0) // nothing was sent to the position yet
+				return false;
+			if (difference > 0)
+				position = receivePosition.load(std::memory_order_relaxed);
+			else if (receivePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				value = cell.value;
+				cell.value = Variable();
+				cell.sequence.store(position + cells.size(), std::memory_order_release); // free for the sender of the position one round later
+				return true;
+			}
+		}
+	}
+
+	std::vector<Cell> cells;
+	size_t mask;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> sendPosition = 0;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> receivePosition = 0;
+};
+
+inline std::shared_ptr<Channel>& FindChannel(ScriptContext& context, int channel) // with channelsMutex held
+{
+	if (channel < 0 || channel >= (int)context.channels.size() || context.channels[channel] == nullptr)
+		throw std::runtime_error("Channel " + std::to_string(channel) + " does not exist or was closed");
+	return context.channels[channel];
+}
+
+inline std::shared_ptr<Channel> GetChannel(ScriptContext& context, int channel)
+{
+	std::shared_lock<std::shared_mutex> lock(context.channelsMutex);
+	return FindChannel(context, channel);
+}
+
+inline void WakeWaitingThreads(ScriptContext& context, Channel& channel) // after a value was sent or received
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the fence in Wait, either this sees the waiting thread or that thread sees the change
+	if (channel.waitingThreadCount.load(std::memory_order_relaxed) == 0)
+		return;
+	std::lock_guard<std::mutex> lock(context.waitMutex); // a thread that has just checked the channel cannot miss this before it waits
+	context.waitChanged.notify_all();
+}
+
+// spins first, since the other side usually takes far less time than it takes to sleep and wake up again
+// before sleeping, iterations of a parallel for that did not start yet get a thread, they could be the other side, and the wait fails if no thread could ever end it
+template<typename F> inline void Wait(ScriptContext& context, Channel& channel, int id, const char* function, F tryOnce)
+{
+	for (size_t attempt = 0; attempt < CHANNEL_SPIN_COUNT; attempt++)
+	{
+		if (tryOnce())
+			return;
+		if (attempt >= CHANNEL_SPIN_COUNT / 2)
+			std::this_thread::yield();
+	}
+
+	Parallel::StartHelper(&context);
+	std::unique_lock<std::mutex> lock(context.waitMutex);
+	channel.waitingThreadCount++;
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	context.BeginWait();
+	while (!tryOnce())
+	{
+		std::string error = channel.isClosed ? " was closed while waiting" : context.isDeadlocked ? " would wait forever, every thread of the script is waiting" : "";
+		if (!error.empty())
+		{
+			channel.waitingThreadCount--;
+			context.EndWait();
+			throw std::runtime_error(std::string(function) + ": channel " + std::to_string(id) + error);
+		}
+		context.waitChanged.wait(lock);
+	}
+	channel.waitingThreadCount--;
+	context.EndWait();
+}
+
+int Channels::Create(ScriptContext& context, size_t capacity, bool isSingleProducer)
+{
+	std::unique_lock<std::shared_mutex> lock(context.channelsMutex); // a closed channel leaves an empty place, so that its int is never given to another channel
+	if (isSingleProducer)
+		context.channels.push_back(std::make_shared<SingleProducerChannel>(capacity));
+	else
+		context.channels.push_back(std::make_shared<MultiProducerChannel>(capacity));
+	return (int)context.channels.size() - 1;
+}
+
+bool Channels::TrySend(ScriptContext& context, int channel, const Variable& value)
+{
+	std::shared_ptr<Channel> target = GetChannel(context, channel);
+	if (!target->TrySend(value))
+		return false;
+	WakeWaitingThreads(context, *target);
+	return true;
+}
+
+void Channels::Send(ScriptContext& context, int channel, const Variable& value)
+{
+	std::shared_ptr<Channel> target = GetChannel(context, channel);
+	Wait(context, *target, channel, "Send", [&]() { return target->TrySend(value); });
+	WakeWaitingThreads(context, *target);
+}
+
+bool Channels::TryReceive(ScriptContext& context, int channel, Variable& value)
+{
+	std::shared_ptr<Channel> source = GetChannel(context, channel);
+	if (!source->TryReceive(value))
+		return false;
+	WakeWaitingThreads(context, *source);
+	return true;
+}
+
+Variable Channels::Receive(ScriptContext& context, int channel)
+{
+	std::shared_ptr<Channel> source = GetChannel(context, channel);
+	Variable ret;
+	Wait(context, *source, channel, "Receive", [&]() { return source->TryReceive(ret); });
+	WakeWaitingThreads(context, *source);
+	return ret;
+}
+
+void Channels::Close(ScriptContext& context, int channel)
+{
+	std::shared_ptr<Channel> closed;
+	{
+		std::unique_lock<std::shared_mutex> lock(context.channelsMutex);
+		closed = std::move(FindChannel(context, channel));
+	}
+	closed->isClosed = true;
+	std::lock_guard<std::mutex> lock(context.waitMutex);
+	context.waitChanged.notify_all();
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <atomic>
+#include "common.hpp"
+
+class ScriptContext;
+
+struct Channel // the channels belong to the ScriptContext of the script that created them
+{
+	virtual ~Channel() = default;
+	virtual bool TrySend(const Variable& value) = 0;
+	virtual bool TryReceive(Variable& value) = 0;
+
+	std::atomic<size_t> waitingThreadCount = 0; // a thread that sent or received only wakes the waiting ones if there are any
+	std::atomic<bool> isClosed = false;
+};
+
+// bounded queues that hand values from one thread to another, scripts use them through std/channel.script and identify them by the int that creating them returned
+// neither kind takes a lock to send or receive, a thread that has to wait for the other side spins for a while and then sleeps until it is woken
+// a thread that would wait while iterations of a parallel for have not started yet gets them another thread first, since they could be the other side
+// a wait throws once every thread of the script waits, then none of them can ever be woken
+namespace Channels
+{
+	inline extern int Create(ScriptContext& context, size_t capacity, bool isSingleProducer); // a single producer channel may only be sent to by one thread and received from by one thread at a time
+	inline extern bool TrySend(ScriptContext& context, int channel, const Variable& value);   // returns false if the channel is full
+	inline extern void Send(ScriptContext& context, int channel, const Variable& value);      // waits while the channel is full
+	inline extern bool TryReceive(ScriptContext& context, int channel, Variable& value);      // returns false if the channel is empty
+	inline extern Variable Receive(ScriptContext& context, int channel);                      // waits while the channel is empty
+	inline extern void Close(ScriptContext& context, int channel);                            // the threads that wait for it throw, values that were not received are dropped
+}
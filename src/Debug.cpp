@@ -21,9 +21,9 @@ std::string Debug::DumpStackFrame(const StackFrame* stackFrame)
 		const Scope& scope = stackFrame->At(i);
 		if (scope.size() == 0)
 			currentScope += "    None\n";
-		for (const std::pair<std::string, Variable>& pair : scope)
+		for (const std::pair<const Symbol, Variable>& pair : scope)
 		{
-			currentScope += "    " + pair.first + " (" + DataTypeToString(pair.second.type) + ")\n";
+			currentScope += "    " + SymbolTable::GetName(pair.first) + " (" + DataTypeToString(pair.second.type) + ")\n";
 		}
 		ret += currentScope;
 	}
@@ -42,13 +42,13 @@ std::string Debug::DumpInstructionData(const Instruction& instruction)
 		ret.push_back(' ');
 
 	if (instruction.operand1.dataType != DATA_TYPE_INVALID)
-		ret += " " + (instruction.operand1.literalValue.empty() ? instruction.operand1.name : instruction.operand1.literalValue)/* + " (" + DataTypeToString(instruction.operand1.dataType) + ")"*/;
+		ret += " " + (instruction.operand1.literalValue.empty() ? SymbolTable::GetName(instruction.operand1.name) : instruction.operand1.literalValue)/* + " (" + DataTypeToString(instruction.operand1.dataType) + ")"*/;
 
 	while (ret.size() < distanceBeforeOp1 + distanceBeforeOp2)
 		ret.push_back(' ');
 
 	if (instruction.operand2.dataType != DATA_TYPE_INVALID)
-		ret += " " + (instruction.operand2.literalValue.empty() ? instruction.operand2.name : instruction.operand2.literalValue)/* + " (" + DataTypeToString(instruction.operand2.dataType) + ")"*/;
+		ret += " " + (instruction.operand2.literalValue.empty() ? SymbolTable::GetName(instruction.operand2.name) : instruction.operand2.literalValue)/* + " (" + DataTypeToString(instruction.operand2.dataType) + ")"*/;
 
 	return ret;
 }
@@ -80,7 +80,7 @@ std::string Debug::DumpToken(Lexer::Token& token)
 		ret += '0';
 	ret += line + ' ';
 
-	ret += " content: " + token.content;
+	ret += " content: " + std::string(token.content);
 	for (int i = 0; i < contentLength - token.content.size(); i++)
 		ret += ' ';
 
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include "FileIO.hpp"
+#include "ScriptContext.hpp"
+
+constexpr size_t FILE_WRITE_BUFFER_SIZE = 1 << 20;
+
+OpenFile::OpenFile(const std::string& path, bool isWritten) : path(path), isWritten(isWritten)
+{
+	if (!isWritten)
+	{
+		mapping = MappedFile(path);
+		return;
+	}
+	stream.open(path, std::ios::binary | std::ios::trunc);
+	if (!stream)
+		throw std::runtime_error("Failed to create file " + path);
+	buffer.reserve(FILE_WRITE_BUFFER_SIZE);
+}
+
+OpenFile::~OpenFile()
+{
+	try
+	{
+		Flush();
+	}
+	catch (std::exception& ex) // the file was not closed by the script, so there is nothing left that could handle the error
+	{
+		std::cerr << ex.what() << "\n";
+	}
+}
+
+void OpenFile::Flush()
+{
+	if (buffer.empty())
+		return;
+	stream.write(buffer.data(), (std::streamsize)buffer.size());
+	buffer.clear();
+	if (!stream)
+		throw std::runtime_error("Failed to write to file " + path);
+}
+
+inline std::unique_ptr<OpenFile>& GetOpenFile(ScriptContext& context, int file)
+{
+	std::vector<std::unique_ptr<OpenFile>>& files = context.files;
+	if (file < 0 || file >= (int)files.size() || files[file] == nullptr)
+		throw std::runtime_error("File " + std::to_string(file) + " is not open");
+	return files[file];
+}
+
+inline OpenFile& GetFile(ScriptContext& context, int file, bool isWritten)
+{
+	OpenFile& ret = *GetOpenFile(context, file);
+	if (ret.isWritten != isWritten)
+		throw std::runtime_error("File " + ret.path + " was opened for " + (ret.isWritten ? "writing" : "reading"));
+	return ret;
+}
+
+int FileIO::OpenForReading(ScriptContext& context, const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(context.filesMutex);
+	std::vector<std::unique_ptr<OpenFile>>& files = context.files; // a closed file leaves an empty place, so that its int is never given to another file
+	files.push_back(std::make_unique<OpenFile>(path, false));
+	return (int)files.size() - 1;
+}
+
+int FileIO::OpenForWriting(ScriptContext& context, const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(context.filesMutex);
+	std::vector<std::unique_ptr<OpenFile>>& files = context.files;
+	files.push_back(std::make_unique<OpenFile>(path, true));
+	return (int)files.size() - 1;
+}
+
+std::string FileIO::ReadLine(ScriptContext& context, int file)
+{
+	std::lock_guard<std::mutex> lock(context.filesMutex);
+	OpenFile& openFile = GetFile(context, file, false);
+	std::string_view rest = openFile.mapping.View().substr(openFile.readPosition);
+	const char* newline = (const char*)memchr(rest.data(), '\n', rest.size());
+
+	std::string_view ret = rest.substr(0, newline == nullptr ? rest.size() : newline - rest.data());
+	openFile.readPosition += ret.size() + (newline == nullptr ? 0 : 1);
+	if (!ret.empty() && ret.back() == '\r')
+		ret.remove_suffix(1);
+	return std::string(ret); // copied while the lock is held, another thread may close the file and unmap it right after
+}
+
+std::string FileIO::ReadChunk(ScriptContext& context, int file, size_t size)
+{
+	std::lock_guard<std::mutex> lock(context.filesMutex);
+	OpenFile& openFile = GetFile(context, file, false);
+	std::string_view ret = openFile.mapping.View().substr(openFile.readPosition, size);
+	openFile.readPosition += ret.size();
+	return std::string(ret);
+}
+
+bool FileIO::IsAtEnd(ScriptContext& context, int file)
+{
+	std::lock_guard<std::mutex> lock(context.filesMutex);
+	OpenFile& openFile = GetFile(context, file, false);
+	return openFile.readPosition >= openFile.mapping.Size();
+}
+
+void FileIO::Write(ScriptContext& context, int file, std::string_view text)
+{
+	std::lock_guard<std::mutex> lock(context.filesMutex);
+	OpenFile& openFile = GetFile(context, file, true);
+	if (openFile.buffer.size() + text.size() > FILE_WRITE_BUFFER_SIZE)
+		openFile.Flush();
+
+	if (text.size() >= FILE_WRITE_BUFFER_SIZE) // copying text this large into the buffer first would not save any writes
+	{
+		openFile.stream.write(text.data(), (std::streamsize)text.size());
+		if (!openFile.stream)
+			throw std::runtime_error("Failed to write to file " + openFile.path);
+	}
+	else
+		openFile.buffer.insert(openFile.buffer.end(), text.begin(), text.end());
+}
+
+void FileIO::Close(ScriptContext& context, int file)
+{
+	std::lock_guard<std::mutex> lock(context.filesMutex);
+	std::unique_ptr<OpenFile>& openFile = GetOpenFile(context, file);
+	openFile->Flush(); // the destructor flushes as well, but a failed write can only be reported to the script from here
+	openFile.reset();
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include "MappedFile.hpp"
+
+class ScriptContext;
+
+struct OpenFile // the open files belong to the ScriptContext of the script that opened them
+{
+	OpenFile(const std::string& path, bool isWritten);
+	~OpenFile();
+	void Flush();
+
+	std::string path;
+	bool isWritten;
+	MappedFile mapping;
+	size_t readPosition = 0;
+	std::ofstream stream;
+	std::vector<char> buffer;
+};
+
+// the files that scripts read and write through std/file.script, an open file is identified by the int that opening it returned
+// files are read through a memory mapping, so reading a line or a chunk only touches that part of the file, however large the file is
+// files are written through a large buffer, a file that is still open when the program ends is flushed and closed then
+// every call locks the files of the script, so the iterations of a parallel for can share an open file
+namespace FileIO
+{
+	inline extern int OpenForReading(ScriptContext& context, const std::string& path);
+	inline extern int OpenForWriting(ScriptContext& context, const std::string& path); // creates the file, or empties it if it exists
+	inline extern std::string ReadLine(ScriptContext& context, int file);         // without the newline, returns an empty line at the end of the file
+	inline extern std::string ReadChunk(ScriptContext& context, int file, size_t size); // less than size chars at the end of the file
+	inline extern bool IsAtEnd(ScriptContext& context, int file);
+	inline extern void Write(ScriptContext& context, int file, std::string_view text);
+	inline extern void Close(ScriptContext& context, int file);
+}
@@ -1,30 +1,39 @@
 #include <iostream>
 #include <stdexcept>
+#include <mutex>
 #include "Function.hpp"
 #include "Interpreter.hpp"
+#include "Parser.hpp"
 #include "Debug.hpp"
 #include "Behavior.hpp"
+#include "ScriptContext.hpp"
 
-Function::Function(Function* function)
-{
-	this->name = function->name;
-	this->parameters = function->parameters;
-	this->returnType = function->returnType;
-	this->instructions = function->instructions;
-}
-
-Function::Function(FunctionInfo& info)
+Function::Function(ScriptContext& context, FunctionInfo& info)
 {
+	this->context = &context;
 	this->name = info.name;
 	this->parameters = info.parameters;
 	this->returnType = info.returnType;
 	this->instructions = info.instructions;
-	CreateParameters();
-	if (Behavior::dumpFunctionInstructions && !instructions.empty())
-	{
-		std::cout << "Function \"" << name << "\" instruction dump:\n";
-		std::cout << Debug::DumpInstructionsData(instructions) << "\n";
-	}
+	this->body = info.body;
+	this->isCompiled = info.isCompiled;
+	if (isCompiled)
+		FinishCompilation();
+}
+
+void Function::Compile()
+{
+	std::lock_guard<std::mutex> lock(context->compilationMutex);
+	if (isCompiled) // another thread was compiling it while this one waited
+		return;
+
+	if (context->behavior.verbose)
+		std::cout << "Compiling function " << GetName() << " on its first call\n";
+
+	FunctionInfo info{ name, parameters, {}, returnType, body, false };
+	Parser::CompileFunction(*context, info);
+	instructions = std::move(info.instructions);
+	FinishCompilation();
 }
 
 void Function::CreateParameters()
@@ -44,31 +53,38 @@ void Function::CreateParameters()
 	}
 }
 
-void Function::ExecuteBody()
-{
-	if (!Interpreter::ExecuteInstructions(instructions))
-		throw std::runtime_error("Failed to execute an instruction");
-	Execute();
-}
-
-void Function::Return(VariableInfo info)
+void Function::FinishCompilation()
 {
-	static Instruction returnInst{ INSTRUCTION_TYPE_RETURN };
-	if (returnType == DATA_TYPE_VOID || DATA_TYPE_INVALID)
+	CreateParameters();
+	if (context->behavior.dumpFunctionInstructions && !instructions.empty())
 	{
-		Interpreter::ExecuteInstructions({ returnInst });
-		return;
+		std::cout << "Function \"" << GetName() << "\" instruction dump:\n";
+		std::cout << Debug::DumpInstructionsData(instructions) << "\n";
 	}
+	isCompiled = true; // only after the instructions are complete, other threads start using them as soon as this is set
+}
 
-	Instruction assignInst{};
-	assignInst.type = INSTRUCTION_TYPE_ASSIGN;
-	assignInst.operand1 = floatReturnVar;
-	assignInst.operand2 = info;
+void Function::ExecuteBody(Interpreter& interpreter)
+{
+	if (!isCompiled)
+		Compile();
+	if (!interpreter.ExecuteInstructions(instructions))
+		throw std::runtime_error("Failed to execute an instruction");
+}
 
-	Interpreter::ExecuteInstructions({ assignInst, returnInst });
+bool Function::ResumeBody(Interpreter& interpreter, size_t& instructionPointer)
+{
+	if (!isCompiled)
+		Compile();
+	return interpreter.ExecuteUntilYield(instructions, instructionPointer);
 }
 
 std::string Function::GetName()
+{
+	return SymbolTable::GetName(name);
+}
+
+Symbol Function::GetSymbol()
 {
 	return name;
 }
\ No newline at end of file
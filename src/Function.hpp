@@ -1,38 +1,55 @@
 #pragma once
 #include "common.hpp"
 #include "StackFrame.hpp"
+#include "Lexer.hpp"
 #include <unordered_map>
+#include <span>
+#include <atomic>
 
 struct FunctionInfo
 {
-	std::string name;
+	Symbol name = SYMBOL_NONE;
 	std::vector<VariableInfo> parameters;
 	std::vector<Instruction> instructions;
 	DataType returnType = DATA_TYPE_VOID;
+	std::span<const Lexer::Token> body; // the tokens inside the brackets of the body, these have to outlive the function
+	bool isCompiled = true; // a body that is not compiled yet gets its instructions on the first call
+
+	// only set when compiled functions are cached, the instructions of a function can be reused as long as all three hashes stay the same
+	uint64_t signatureHash = 0;  // of the tokens of the signature
+	uint64_t bodyHash = 0;       // of the tokens of the signature and the body
+	uint64_t dependencyHash = 0; // of the signatures of the functions that the body calls
 };
 
+class ScriptContext;
+class Interpreter;
+
 class Function
 {
 public:
 	Function() = default;
-	Function(Function* function);
-	Function(FunctionInfo& info);
+	Function(ScriptContext& context, FunctionInfo& info);
 	~Function() {}
 
-	void ExecuteBody();
+	void ExecuteBody(Interpreter& interpreter); // on the stack of the interpreter, which belongs to the calling thread
+	bool ResumeBody(Interpreter& interpreter, size_t& instructionPointer); // for generators, returns true if the body stopped at a yield
 
 	std::string GetName();
+	Symbol GetSymbol();
 
 protected:
-	virtual void Execute() {}
-	void Return(VariableInfo info);
-	std::string name = "";
+	Symbol name = SYMBOL_NONE;
 	std::vector<VariableInfo> parameters;
 	DataType returnType = DATA_TYPE_INVALID;
 	StackFrame stackFrame{};
 
 private:
+	void Compile();
+	void FinishCompilation();
 	void CreateParameters();
 
+	ScriptContext* context = nullptr; // of the script that declared it, a body that was not compiled yet is compiled with it
 	std::vector<Instruction> instructions;
+	std::span<const Lexer::Token> body;
+	std::atomic<bool> isCompiled = true; // the body of a parallel for can call a function for the first time on several threads at once
 };
\ No newline at end of file
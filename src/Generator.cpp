@@ -0,0 +1,90 @@
+#include <memory>
+#include <mutex>
+#include <string>
+#include <stdexcept>
+#include "Generator.hpp"
+#include "Interpreter.hpp"
+#include "ScriptContext.hpp"
+
+inline std::shared_ptr<Generator>& FindGenerator(ScriptContext& context, int generator) // with generatorsMutex held
+{
+	std::vector<std::shared_ptr<Generator>>& generators = context.generators;
+	if (generator < 0 || generator >= (int)generators.size() || generators[generator] == nullptr)
+		throw std::runtime_error("Generator " + std::to_string(generator) + " does not exist or was stopped");
+	return generators[generator];
+}
+
+inline std::shared_ptr<Generator> GetGenerator(ScriptContext& context, int generator)
+{
+	std::lock_guard<std::mutex> lock(context.generatorsMutex);
+	return FindGenerator(context, generator);
+}
+
+class GeneratorUse // marks a generator as running for as long as it exists
+{
+public:
+	GeneratorUse(Generator& state, int generator, const char* function) : state(state)
+	{
+		if (state.isRunning.exchange(true))
+			throw std::runtime_error(std::string(function) + ": generator " + std::to_string(generator) + " is already running, it cannot be asked for values from two threads at once or from its own body");
+	}
+
+	~GeneratorUse()
+	{
+		state.isRunning = false;
+	}
+
+private:
+	Generator& state;
+};
+
+inline bool Advance(ScriptContext& context, Generator& state) // runs the body up to its next yield if no value is waiting, while the generator is marked as running
+{
+	if (state.hasValue || state.isFinished)
+		return state.hasValue;
+
+	Interpreter& interpreter = context.GetInterpreter(); // the body runs on the stack of the thread that asks for the value
+	bool yielded = interpreter.ResumeGenerator(state.function, state.arguments, state.frame, state.instructionPointer);
+	state.arguments.clear(); // the body pulled them when it started
+	if (!yielded)
+	{
+		state.isFinished = true;
+		return false;
+	}
+	state.value = *interpreter.FindVariable(floatReturnVar.name); // copied out before anything else writes to %frv
+	state.hasValue = true;
+	return true;
+}
+
+int Generators::Start(ScriptContext& context, Symbol function, const std::vector<Variable>& arguments)
+{
+	std::shared_ptr<Generator> generator = std::make_shared<Generator>();
+	generator->function = function;
+	generator->arguments = arguments;
+	std::lock_guard<std::mutex> lock(context.generatorsMutex);
+	context.generators.push_back(std::move(generator)); // a stopped generator leaves an empty place, so that its int is never given to another generator
+	return (int)context.generators.size() - 1;
+}
+
+bool Generators::HasNext(ScriptContext& context, int generator)
+{
+	std::shared_ptr<Generator> state = GetGenerator(context, generator);
+	GeneratorUse use(*state, generator, "HasNext");
+	return Advance(context, *state);
+}
+
+Variable Generators::Next(ScriptContext& context, int generator)
+{
+	std::shared_ptr<Generator> state = GetGenerator(context, generator);
+	GeneratorUse use(*state, generator, "Next"); // another thread cannot take the same value between checking for it and taking it
+	if (!Advance(context, *state))
+		throw std::runtime_error("Generator " + std::to_string(generator) + " has no values left");
+	state->hasValue = false;
+	return std::move(state->value);
+}
+
+void Generators::Stop(ScriptContext& context, int generator)
+{
+	std::lock_guard<std::mutex> lock(context.generatorsMutex);
+	FindGenerator(context, generator) = nullptr;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include "common.hpp"
+#include "StackFrame.hpp"
+
+class ScriptContext;
+
+struct Generator // the generators belong to the ScriptContext of the script that started them
+{
+	Symbol function;
+	std::vector<Variable> arguments; // only used until the body starts
+	StackFrame frame;
+	size_t instructionPointer = 0;
+	Variable value;                  // the value that the last yield handed over, if hasValue
+	bool hasValue = false;
+	bool isFinished = false;
+	std::atomic<bool> isRunning = false; // while a thread runs the body or takes the value, the others may not
+};
+
+// generators are script functions that yield their values one at a time, started through std/generator.script and identified by the int that starting them returned
+// a generator only runs when its next value is asked for, so a chain of them passes every value through all stages before the next one is made
+// the iterations of a parallel for can start generators of their own, but asking one generator for values from two threads at once throws
+namespace Generators
+{
+	inline extern int Start(ScriptContext& context, Symbol function, const std::vector<Variable>& arguments); // the body does not run before the first value is asked for
+	inline extern bool HasNext(ScriptContext& context, int generator); // runs the body up to its next yield if that has not happened yet
+	inline extern Variable Next(ScriptContext& context, int generator);
+	inline extern void Stop(ScriptContext& context, int generator);    // frees the variables of a generator that is not finished
+}
@@ -0,0 +1,135 @@
+#include <utility>
+#include <string>
+#include <stdexcept>
+#include "HashMap.hpp"
+
+constexpr size_t MIN_SLOT_COUNT = 16;
+
+uint32_t HashMap::Hash(const Variable& key)
+{
+	if (DataTypeIsString(key.type))
+	{
+		uint64_t hash = HashContent(key.GetStringView());
+		return (uint32_t)(hash ^ (hash >> 32));
+	}
+	if (DataTypeIsInt(key.type) || DataTypeIsChar(key.type))
+		return (uint32_t)(((uint64_t)(uint32_t)(int)key * 0x9E3779B97F4A7C15ull) >> 32); // fibonacci hashing spreads consecutive ints over the whole table
+	throw std::runtime_error("A map key has to be an int or a string, not a " + DataTypeToInternalTypeString(key.type));
+}
+
+bool HashMap::KeysAreEqual(const Variable& key, const Variable& other)
+{
+	if (DataTypeIsString(key.type) || DataTypeIsString(other.type))
+		return DataTypeIsString(key.type) && DataTypeIsString(other.type) && key.GetStringView() == other.GetStringView();
+	return (int)key == (int)other;
+}
+
+size_t HashMap::GetProbeDistance(size_t slot, uint32_t hash) const
+{
+	return (slot - (hash & (slots.size() - 1))) & (slots.size() - 1);
+}
+
+size_t HashMap::FindSlot(const Variable& key, uint32_t hash) const
+{
+	if (slots.empty())
+		return 0;
+
+	for (size_t i = hash & (slots.size() - 1), distance = 0;; i = (i + 1) & (slots.size() - 1), distance++)
+	{
+		const Slot& slot = slots[i];
+		if (slot.entry == EMPTY_SLOT || GetProbeDistance(i, slot.hash) < distance) // the key would have taken this slot if it was in the map
+			return slots.size();
+		if (slot.hash == hash && KeysAreEqual(entries[slot.entry].key, key))
+			return i;
+	}
+}
+
+void HashMap::InsertSlot(Slot slot)
+{
+	for (size_t i = slot.hash & (slots.size() - 1), distance = 0;; i = (i + 1) & (slots.size() - 1), distance++)
+	{
+		if (slots[i].entry == EMPTY_SLOT)
+		{
+			slots[i] = slot;
+			return;
+		}
+		size_t existingDistance = GetProbeDistance(i, slots[i].hash);
+		if (existingDistance < distance) // the slot is taken from the entry that is closer to its ideal slot, which then continues looking
+		{
+			std::swap(slots[i], slot);
+			distance = existingDistance;
+		}
+	}
+}
+
+void HashMap::Grow()
+{
+	slots.assign(slots.empty() ? MIN_SLOT_COUNT : slots.size() * 2, Slot{});
+	for (size_t i = 0; i < entries.size(); i++)
+		InsertSlot({ (uint32_t)i, entries[i].hash });
+}
+
+void HashMap::CheckNotShared(const char* change) const
+{
+	if (shareCount > 0)
+		throw std::runtime_error("Cannot " + std::string(change) + " a map inside a parallel for, it is shared by all iterations");
+}
+
+Variable* HashMap::Find(const Variable& key)
+{
+	size_t slot = FindSlot(key, Hash(key));
+	return slot < slots.size() ? &entries[slots[slot].entry].value : nullptr;
+}
+
+Variable& HashMap::FindOrInsert(const Variable& key)
+{
+	CheckNotShared("store to");
+	uint32_t hash = Hash(key);
+	size_t slot = FindSlot(key, hash);
+	if (slot < slots.size())
+		return entries[slots[slot].entry].value;
+
+	if ((entries.size() + 1) * 8 > slots.size() * 7) // robin hood hashing keeps the probes short up to a high load
+		Grow();
+
+	Entry& entry = entries.emplace_back();
+	if (DataTypeIsString(key.type)) // constants are stored as their normal type
+		entry.key = Variable((std::string)key);
+	else
+		entry.key = Variable((int)key);
+	entry.value = Variable(VariableInfo{ SYMBOL_NONE, DATA_TYPE_VOID, 0, "" });
+	entry.hash = hash;
+	InsertSlot({ (uint32_t)(entries.size() - 1), hash });
+	return entry.value;
+}
+
+bool HashMap::Erase(const Variable& key)
+{
+	CheckNotShared("remove a key from");
+	size_t slot = FindSlot(key, Hash(key));
+	if (slot >= slots.size())
+		return false;
+
+	uint32_t erased = slots[slot].entry;
+	for (size_t next = (slot + 1) & (slots.size() - 1); slots[next].entry != EMPTY_SLOT && GetProbeDistance(next, slots[next].hash) > 0; next = (next + 1) & (slots.size() - 1))
+	{
+		slots[slot] = slots[next]; // the following entries move one slot closer to their ideal slot, so no tombstone is needed
+		slot = next;
+	}
+	slots[slot] = Slot{};
+
+	if (erased != entries.size() - 1)
+	{
+		slots[FindSlot(entries.back().key, entries.back().hash)].entry = erased;
+		entries[erased] = std::move(entries.back());
+	}
+	entries.pop_back();
+	return true;
+}
+
+void HashMap::Clear()
+{
+	CheckNotShared("clear");
+	entries.clear();
+	slots.clear();
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include "common.hpp"
+
+// the entries of a map, keyed by ints or strings
+// the entries are stored next to each other and the slots only refer to them, so a lookup goes through a small array of slots and then touches a single entry
+// the slots use robin hood hashing: an insert takes over the slot of an entry that is closer to its ideal slot, which keeps every probe sequence short
+// a map that the iterations of a parallel for can reach is shared while the loop runs, then it can only be read, a change throws instead of racing with the other iterations
+class HashMap
+{
+public:
+	struct Entry
+	{
+		Variable key;
+		Variable value;
+		uint32_t hash = 0;
+	};
+
+	Variable* Find(const Variable& key); // returns nullptr if the key is not in the map
+	Variable& FindOrInsert(const Variable& key); // a new entry has a void value
+	bool Erase(const Variable& key); // the last entry takes the place of the erased one, so the entries stay next to each other
+	void Clear();
+
+	void BeginSharing() { shareCount++; } // once for every parallel for that shares the map
+	void EndSharing() { shareCount--; }
+
+	size_t Size() const { return entries.size(); }
+	const Entry& GetEntry(size_t index) const { return entries[index]; }
+
+private:
+	static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+	struct Slot
+	{
+		uint32_t entry = EMPTY_SLOT;
+		uint32_t hash = 0; // compared before the key, so that most mismatches do not have to look at the entry
+	};
+
+	static uint32_t Hash(const Variable& key); // throws if the key is not an int or a string
+	static bool KeysAreEqual(const Variable& key, const Variable& other);
+
+	size_t FindSlot(const Variable& key, uint32_t hash) const; // returns slots.size() if the key is not in the map
+	size_t GetProbeDistance(size_t slot, uint32_t hash) const;
+	void InsertSlot(Slot slot);
+	void Grow();
+	void CheckNotShared(const char* change) const;
+
+	std::vector<Entry> entries;
+	std::vector<Slot> slots; // the number of slots is zero or a power of two
+	std::atomic<uint32_t> shareCount = 0;
+};
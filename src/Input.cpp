@@ -0,0 +1,85 @@
+#include <vector>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include "Input.hpp"
+#include "Output.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#define ReadStdin(destination, size) _read(0, destination, (unsigned int)(size))
+#else
+#include <unistd.h>
+#define ReadStdin(destination, size) read(0, destination, size)
+#endif
+
+constexpr size_t INPUT_CHUNK_SIZE = 1 << 16;
+
+Input::Input(Output& output) : output(output) {}
+
+bool Input::FillBuffer()
+{
+	if (reachedEnd)
+		return false;
+	output.Flush();
+
+	if (readPosition > 0) // the part that was already handed out is dropped, the rest moves to the front
+	{
+		memmove(buffer.data(), buffer.data() + readPosition, bufferedEnd - readPosition);
+		bufferedEnd -= readPosition;
+		readPosition = 0;
+	}
+	if (buffer.size() - bufferedEnd < INPUT_CHUNK_SIZE) // only grows if a single line is longer than the buffer
+		buffer.resize(bufferedEnd + INPUT_CHUNK_SIZE);
+
+	auto readCount = ReadStdin(buffer.data() + bufferedEnd, INPUT_CHUNK_SIZE); // unlike fread this returns as soon as a terminal has a line ready
+	if (readCount <= 0)
+	{
+		reachedEnd = true;
+		return false;
+	}
+	bufferedEnd += (size_t)readCount;
+	return true;
+}
+
+std::string Input::ReadLine()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t searchedCount = 0;
+	while (true)
+	{
+		const char* begin = buffer.data() + readPosition;
+		const char* newline = (const char*)memchr(begin + searchedCount, '\n', bufferedEnd - readPosition - searchedCount);
+		if (newline != nullptr)
+		{
+			std::string_view ret(begin, newline - begin);
+			readPosition += ret.size() + 1;
+			if (!ret.empty() && ret.back() == '\r')
+				ret.remove_suffix(1);
+			return std::string(ret);
+		}
+
+		searchedCount = bufferedEnd - readPosition;
+		if (!FillBuffer()) // the last line does not have to end with a newline
+		{
+			std::string ret(buffer.data() + readPosition, bufferedEnd - readPosition);
+			readPosition = bufferedEnd;
+			return ret;
+		}
+	}
+}
+
+std::string Input::ReadAll()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	while (FillBuffer());
+	std::string ret(buffer.data() + readPosition, bufferedEnd - readPosition);
+	readPosition = bufferedEnd;
+	return ret;
+}
+
+bool Input::IsAtEnd()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return readPosition == bufferedEnd && !FillBuffer();
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+
+class Output;
+
+// stdin is read in large chunks straight into one buffer instead of through std::cin
+// lines are copied out of that buffer while holding its lock, a view into it could be moved by another thread reading at the same time
+// anything that was written to the output is flushed before the program waits for input, it is usually the prompt for it
+// every ScriptContext has its own buffer, but they all read the one stdin of the process, so only one script in a process should read input
+class Input
+{
+public:
+	Input(Output& output);
+	Input(const Input&) = delete;
+	Input& operator=(const Input&) = delete;
+
+	std::string ReadLine(); // without the newline, returns an empty line at the end of the input
+	std::string ReadAll();  // everything that was not read yet
+	bool IsAtEnd();
+
+private:
+	bool FillBuffer(); // returns false if there is nothing left to read
+
+	Output& output; // of the same script
+	std::vector<char> buffer;
+	size_t readPosition = 0; // everything before this has been handed out
+	size_t bufferedEnd = 0;
+	bool reachedEnd = false;
+	std::mutex mutex; // the threads of a parallel for read from the same buffer
+};
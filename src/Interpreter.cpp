@@ -1,38 +1,48 @@
 #include <iostream>
 #include <stdexcept>
+#include <thread>
+#include <algorithm>
 #include "Interpreter.hpp"
 #include "Parser.hpp"
 #include "Debug.hpp"
-#include "Behavior.hpp"
+#include "Parallel.hpp"
+#include "ScriptContext.hpp"
+#include "HashMap.hpp"
 #include "common.hpp"
 
-Scope Interpreter::cacheVariables;
+constexpr size_t PARALLEL_FOR_BLOCKS_PER_THREAD = 4; // more blocks than threads lets a thread that finishes early take over work, fewer keeps the threads from contending for the next block
 
-std::unordered_map<std::string, Function*> Interpreter::functions;
-std::unordered_map<std::string, std::vector<Variable>> Interpreter::buffers;
-Stack Interpreter::stack;
-
-void Interpreter::Init()
+Interpreter::Interpreter(ScriptContext& context) : context(context), treatVoidAsError(context.behavior.treatVoidAsError)
 {
-	DeclareCacheVariable(floatCalculationVar);
 	DeclareCacheVariable(floatStorageVar);
 	DeclareCacheVariable(floatReturnVar);
 	DeclareCacheVariable(leftBoolValue);
 	DeclareCacheVariable(rightBoolValue);
+	DeclareCacheVariable(arrayIndexVar);
 	DeclareBuffer(bufferParametersVar.name);
 }
 
-void Interpreter::SetAST(AbstractSyntaxTree& ast)
+void Interpreter::SetAST(ScriptContext& context, AbstractSyntaxTree& ast)
 {
+	std::unordered_map<Symbol, Function*>& functions = context.functions;
 	for (Function* fnPtr : ast.functions)
 	{
-		functions[fnPtr->GetName()] = fnPtr;
+		functions[fnPtr->GetSymbol()] = fnPtr;
 	}
 }
 
 bool Interpreter::ExecuteInstructions(std::vector<Instruction> instructions)
 {
-	for (size_t instructionPointer = 0; instructionPointer < instructions.size(); instructionPointer++)
+	size_t instructionPointer = 0;
+	if (ExecuteUntilYield(instructions, instructionPointer))
+		throw std::runtime_error("Cannot yield outside of a generator, a function that yields has to be started with Generate");
+	return true;
+}
+
+bool Interpreter::ExecuteUntilYield(std::vector<Instruction>& instructions, size_t& instructionPointer, size_t end)
+{
+	end = std::min(end, instructions.size());
+	for (; instructionPointer < end; instructionPointer++)
 	{
 		Instruction& instruction = instructions[instructionPointer];
 		switch (instruction.type)
@@ -81,8 +91,6 @@ bool Interpreter::ExecuteInstructions(std::vector<Instruction> instructions)
 			*FindVariable(instruction.operand1) = var;// GetValue(instruction.operand2);
 			if (cacheVariables.count(instruction.operand2.name) > 0) // if a cache variable is read from (done being used) it gets reset
 				cacheVariables[instruction.operand2.name] = Variable(VariableInfo{ instruction.operand2.name, DATA_TYPE_VOID, 40 });
-			if (cacheVariables.count(instruction.operand1.name) > 0) // cache variables are always void
-				cacheVariables[instruction.operand1.name].SetDataType(DATA_TYPE_VOID);
 			break;
 		}
 
@@ -96,23 +104,34 @@ bool Interpreter::ExecuteInstructions(std::vector<Instruction> instructions)
 			break;
 		case INSTRUCTION_TYPE_PULL: // pull the oldest value from a buffer
 			if (buffers[instruction.operand1.name].empty())
-				throw std::runtime_error("Cannot pull from buffer " + instruction.operand1.name + ": it is empty");
+				throw std::runtime_error("Cannot pull from buffer " + SymbolTable::GetName(instruction.operand1.name) + ": it is empty");
 			*FindVariable(instruction.operand2) = buffers[instruction.operand1.name][0];
 			buffers[instruction.operand1.name].erase(buffers[instruction.operand1.name].begin());
 			break;
 
 		case INSTRUCTION_TYPE_CALL:
+		{
+			if (auto native = context.nativeFunctions.find(instruction.operand1.name); native != context.nativeFunctions.end())
+			{
+				CallNativeFunction(native->second); // native functions do not need a stack frame of their own
+				break;
+			}
 			stack.CreateNewStackFrame(); // add a new, empty stack
-			if (functions.count(instruction.operand1.name) <= 0)
-				throw std::runtime_error("Cannot find function " + instruction.operand1.name);
-			functions[instruction.operand1.name]->ExecuteBody();
+			auto function = context.functions.find(instruction.operand1.name);
+			if (function == context.functions.end())
+				throw std::runtime_error("Cannot find function " + SymbolTable::GetName(instruction.operand1.name));
+			function->second->ExecuteBody(*this);
 			break;
+		}
 		case INSTRUCTION_TYPE_RETURN:
 			stack.GotoEnclosingStackFrame(); // remove the stack of the finished function
-			break;
+			return false; // a return in the middle of the function must not run the instructions after it
+		case INSTRUCTION_TYPE_YIELD: // the stack frame is left for ResumeGenerator to take
+			instructionPointer++;
+			return true;
 
 		case INSTRUCTION_TYPE_JUMP:
-			instructionPointer += (size_t)std::stoi(instruction.operand1.name) - 1;
+			instructionPointer += (size_t)std::stoi(instruction.operand1.literalValue) - 1;
 			break;
 
 		case INSTRUCTION_TYPE_PUSH_SCOPE:
@@ -122,6 +141,25 @@ bool Interpreter::ExecuteInstructions(std::vector<Instruction> instructions)
 			stack.Last().DecrementScope();
 			break;
 
+		case INSTRUCTION_TYPE_INDEX:
+		{
+			Variable* variable = FindVariable(instruction.operand1);
+			Symbol name = variable->name;
+			*variable = variable->GetElement(GetValue(instruction.operand2));
+			variable->name = name;
+			break;
+		}
+		case INSTRUCTION_TYPE_STORE_INDEX:
+			FindVariable(instruction.operand1)->SetElement(*FindVariable(arrayIndexVar.name), GetValue(instruction.operand2));
+			break;
+
+		case INSTRUCTION_TYPE_PARALLEL_FOR: // the body is everything that the next instruction jumps over, which makes the thread that got here skip it afterwards
+		{
+			size_t bodyEnd = instructionPointer + 1 + (size_t)std::stoi(instructions[instructionPointer + 1].operand1.literalValue);
+			RunParallelFor(instruction.operand1.name, (int)*FindVariable(instruction.operand1), (int)GetValue(instruction.operand2), instructions, instructionPointer + 2, bodyEnd);
+			break;
+		}
+
 		case INSTRUCTION_TYPE_DEREFERENCE: // with deference the first operand is the pointer, the second is the variable to copy to
 		{
 			Variable* location = (Variable*)(uint64_t)GetValue(instruction.operand1);
@@ -136,7 +174,7 @@ bool Interpreter::ExecuteInstructions(std::vector<Instruction> instructions)
 			throw std::runtime_error("Recieved invalid instruction");
 		}
 	}
-	return true;
+	return false;
 }
 
 inline bool IsConstant(DataType type)
@@ -149,9 +187,9 @@ inline Variable GetConstantTypeAsVariable(VariableInfo& info)
 	switch (info.dataType)
 	{
 	case DATA_TYPE_STRING_CONSTANT:
-	case DATA_TYPE_CHAR_CONSTANT:  return Variable(info.name);
-	case DATA_TYPE_FLOAT_CONSTANT: return std::stof(info.name);
-	case DATA_TYPE_INT_CONSTANT:   return std::stoi(info.name);
+	case DATA_TYPE_CHAR_CONSTANT:  return Variable(info.literalValue);
+	case DATA_TYPE_FLOAT_CONSTANT: return std::stof(info.literalValue);
+	case DATA_TYPE_INT_CONSTANT:   return std::stoi(info.literalValue);
 	}
 	return 0;
 }
@@ -175,19 +213,155 @@ Variable Interpreter::GetValue(VariableInfo& info)
 	return *FindVariable(info);
 }
 
-Variable* Interpreter::FindVariable(std::string name)
+Variable* Interpreter::FindVariable(Symbol name)
 {
+	if (IsCalculationRegister(name))
+		return &stack.Last().GetCalculationRegister(name);
 	if (cacheVariables.count(name) > 0)
 		return &cacheVariables[name];
 
 	if (stack.Last().Has(name))
 	{
-		if (Behavior::treatVoidAsError && stack.Last().GetVariable(name).type == DATA_TYPE_VOID)
+		if (treatVoidAsError && stack.Last().GetVariable(name).type == DATA_TYPE_VOID)
 			throw std::runtime_error("Runtime error: invalid type used (type == DATA_TYPE_VOID && treatVoidAsError)\nremove the -treat_void_as_error argument to remove this error");
 		return &stack.Last().GetVariable(name);
 	}
 		
-	throw std::runtime_error("Failed to find variable " + name);
+	throw std::runtime_error("Failed to find variable " + SymbolTable::GetName(name));
+}
+
+Variable* Interpreter::FindVariable(std::string_view name)
+{
+	return FindVariable(SymbolTable::Find(name));
+}
+
+void Interpreter::SetNativeFunction(ScriptContext& context, Symbol name, const NativeFunction& function)
+{
+	context.nativeFunctions[name] = function;
+}
+
+Variable Interpreter::CallFunction(Symbol name, const std::vector<Variable>& arguments)
+{
+	std::vector<Variable> callerArguments; // the calling native function still uses its own arguments, so they are moved aside instead of being pulled by this call
+	std::swap(callerArguments, buffers[bufferParametersVar.name]);
+	buffers[bufferParametersVar.name] = arguments;
+
+	ExecuteInstructions({ { INSTRUCTION_TYPE_CALL, { name } } });
+	std::swap(callerArguments, buffers[bufferParametersVar.name]);
+	return cacheVariables[floatReturnVar.name];
+}
+
+bool Interpreter::ResumeGenerator(Symbol name, const std::vector<Variable>& arguments, StackFrame& frame, size_t& instructionPointer)
+{
+	std::unordered_map<Symbol, Function*>& functions = context.functions;
+	auto function = functions.find(name);
+	if (function == functions.end())
+		throw std::runtime_error("Cannot find function " + SymbolTable::GetName(name));
+
+	std::vector<Variable> callerArguments; // the native function that resumes the generator still uses its own arguments, like with CallFunction
+	std::swap(callerArguments, buffers[bufferParametersVar.name]);
+	if (instructionPointer == 0) // the parameters are pulled by the first instructions of the body
+		buffers[bufferParametersVar.name] = arguments;
+
+	stack.CreateNewStackFrame(std::move(frame));
+	bool yielded = function->second->ResumeBody(*this, instructionPointer);
+	if (yielded) // a return already removed the stack frame
+	{
+		frame = std::move(stack.Last());
+		stack.GotoEnclosingStackFrame();
+	}
+	std::swap(callerArguments, buffers[bufferParametersVar.name]);
+	return yielded;
+}
+
+void Interpreter::CallNativeFunction(const NativeFunction& function)
+{
+	std::vector<Variable>& arguments = buffers[bufferParametersVar.name];
+	Variable& result = cacheVariables[floatReturnVar.name];
+	if (arguments.size() < function.parameterCount)
+		throw std::runtime_error("Cannot call native function " + std::string(function.name) + ": it expects " + std::to_string(function.parameterCount) + " arguments");
+
+	function.thunk(function.function, context, arguments.data(), result);
+	result.name = floatReturnVar.name;
+	arguments.erase(arguments.begin(), arguments.begin() + function.parameterCount); // the arguments are pulled in the order they were pushed
+}
+
+class StackFrameGuard // removes the frame of a block, and the frames of the calls it was in, even if an iteration throws
+{
+public:
+	StackFrameGuard(Stack& stack, const StackFrame& frame) : stack(stack), size(stack.Size())
+	{
+		stack.CreateNewStackFrame(frame);
+	}
+
+	~StackFrameGuard()
+	{
+		while (stack.Size() > size)
+			stack.GotoEnclosingStackFrame();
+	}
+
+private:
+	Stack& stack;
+	size_t size;
+};
+
+inline void CollectMaps(const Variable& var, std::vector<HashMap*>& maps) // the map of the variable and the maps that are stored in it
+{
+	HashMap* map = var.GetMap();
+	if (map == nullptr || std::find(maps.begin(), maps.end(), map) != maps.end())
+		return;
+	maps.push_back(map);
+	for (size_t i = 0; i < map->Size(); i++)
+		CollectMaps(map->GetEntry(i).value, maps);
+}
+
+class SharedMaps // the maps that the iterations can reach through the frame cannot change while the loop runs, the body can also pass them to functions or copy them
+{
+public:
+	SharedMaps(const StackFrame& frame)
+	{
+		for (size_t i = 0; i < frame.Size(); i++)
+			for (const auto& [name, var] : frame.At(i))
+				CollectMaps(var, maps);
+		for (HashMap* map : maps)
+			map->BeginSharing();
+	}
+
+	~SharedMaps()
+	{
+		for (HashMap* map : maps)
+			map->EndSharing();
+	}
+
+private:
+	std::vector<HashMap*> maps;
+};
+
+void Interpreter::RunParallelFor(Symbol loopVariable, int begin, int end, std::vector<Instruction>& instructions, size_t bodyBegin, size_t bodyEnd)
+{
+	if (begin >= end)
+		return;
+
+	const StackFrame frame = stack.Last(); // a copy, the stack of the calling thread grows while it runs blocks itself
+	SharedMaps sharedMaps(frame);
+	size_t count = (size_t)end - begin;
+	size_t blockCount = std::min(count, PARALLEL_FOR_BLOCKS_PER_THREAD * std::max(std::thread::hardware_concurrency(), 1u));
+	Parallel::For(blockCount, [&](size_t block)
+	{
+		Interpreter& interpreter = context.GetInterpreter(); // this one on the calling thread, the threads of the pool have their own for this script
+
+		// the frame is copied once per block, the parser does not let the body assign to the variables of the frame and the body removes its own scope after every iteration
+		// so every iteration starts with the variables as they were before the loop, only arrays are shared and can be changed, since a copy of one refers to the same elements
+		StackFrameGuard guard(interpreter.stack, frame);
+		Variable* index = interpreter.FindVariable(loopVariable);
+		for (size_t i = count * block / blockCount; i < count * (block + 1) / blockCount; i++)
+		{
+			*index = Variable((int)(begin + i));
+			index->name = loopVariable;
+			size_t instructionPointer = bodyBegin; // the body is run where it is, the instructions are only read, so every thread can share them
+			interpreter.ExecuteUntilYield(instructions, instructionPointer, bodyEnd);
+		}
+	});
 }
 
 void Interpreter::DeclareVariable(const VariableInfo& info)
@@ -201,12 +375,12 @@ Variable* Interpreter::FindVariable(VariableInfo& info)
 	return FindVariable(info.name);
 }
 
-void Interpreter::CopyLocalVariableToStackFrame(std::string sourceName, std::string newName, StackFrame* destination)
+void Interpreter::CopyLocalVariableToStackFrame(Symbol sourceName, Symbol newName, StackFrame* destination)
 {
 	destination->Allocate({ newName, DATA_TYPE_VOID });
 }
 
-void Interpreter::DeclareBuffer(std::string name)
+void Interpreter::DeclareBuffer(Symbol name)
 {
 	buffers[name] = {};
 }
@@ -2,54 +2,68 @@
 #include "common.hpp"
 #include "StackFrame.hpp"
 #include "Stack.hpp"
+#include "NativeFunction.hpp"
 #include <unordered_map>
 
 class Function;
 struct AbstractSyntaxTree;
 
-const VariableInfo leftBoolValue =       { "%lbv", DATA_TYPE_INT, sizeof(int) };
-const VariableInfo rightBoolValue =      { "%rbv", DATA_TYPE_INT, sizeof(int) };
-const VariableInfo floatStorageVar =     { "%fsv", DATA_TYPE_VOID, 40 }; // random size
-const VariableInfo floatCalculationVar = { "%fcv", DATA_TYPE_VOID, 40 };
-const VariableInfo floatReturnVar =      { "%frv", DATA_TYPE_VOID, 40 };
-const VariableInfo bufferParametersVar = { "%bpv", DATA_TYPE_VOID, 40 };
+const VariableInfo leftBoolValue =       { SYMBOL_LEFT_BOOL_VALUE,       DATA_TYPE_INT, sizeof(int) };
+const VariableInfo rightBoolValue =      { SYMBOL_RIGHT_BOOL_VALUE,      DATA_TYPE_INT, sizeof(int) };
+const VariableInfo floatStorageVar =     { SYMBOL_FLOAT_STORAGE_VAR,     DATA_TYPE_VOID, 40 }; // random size
+const VariableInfo floatCalculationVar = { SYMBOL_FLOAT_CALCULATION_VAR, DATA_TYPE_VOID, 40 };
+const VariableInfo floatReturnVar =      { SYMBOL_FLOAT_RETURN_VAR,      DATA_TYPE_VOID, 40 };
+const VariableInfo bufferParametersVar = { SYMBOL_BUFFER_PARAMETERS_VAR, DATA_TYPE_VOID, 40 };
+const VariableInfo arrayIndexVar =       { SYMBOL_ARRAY_INDEX_VAR,       DATA_TYPE_INT, sizeof(int) };
 
-inline std::vector<std::string> importedFiles;
+inline VariableInfo GetCalculationRegister(size_t index) // index 0 is floatCalculationVar
+{
+	return { (Symbol)(SYMBOL_FLOAT_CALCULATION_VAR + index), DATA_TYPE_VOID, 40 };
+}
 
+// runs the instructions of a script on one thread, with the registers, buffers and stack of that thread
+// the ScriptContext owns one for every thread that works on its script, so two scripts run alternately on one thread do not share a stack, the functions are in the ScriptContext
 class Interpreter
 {
 public:
-	static void Init();
-	static void SetAST(AbstractSyntaxTree& ast);
+	explicit Interpreter(ScriptContext& context);
+	Interpreter(const Interpreter&) = delete;
+	Interpreter& operator=(const Interpreter&) = delete;
 
-	static bool ExecuteInstructions(const std::vector<Instruction> instructions); // copying isnt the best move
-	static Variable* FindVariable(std::string name);
-	static Variable* FindVariable(VariableInfo& info);
-	static Variable  GetValue(VariableInfo& info);
-	static void DeclareVariable(const VariableInfo& info);
-	static void DeclareBuffer(std::string name);
+	static void SetAST(ScriptContext& context, AbstractSyntaxTree& ast);
 
-	static void CopyLocalVariableToStackFrame(std::string sourceName, std::string newName, StackFrame* destination);
+	bool ExecuteInstructions(const std::vector<Instruction> instructions); // copying isnt the best move
+	Variable* FindVariable(Symbol name);
+	Variable* FindVariable(std::string_view name); // only meant for native functions, everything else already knows the symbol
+	Variable* FindVariable(VariableInfo& info);
+	Variable  GetValue(VariableInfo& info);
+	void DeclareVariable(const VariableInfo& info);
+	void DeclareBuffer(Symbol name);
 
-	template<typename T> static void SetExternFunction(std::string name)
-	{
-		Function* oldFunc = functions[name];
-		Function* newFunc = new T(oldFunc);
-		functions[name] = newFunc;
-		//delete oldFunc; // cant delete cause assert fails?
-	}
+	static void CopyLocalVariableToStackFrame(Symbol sourceName, Symbol newName, StackFrame* destination);
 
-	template<typename T> static T FindVariable(VariableInfo& info)
+	static void SetNativeFunction(ScriptContext& context, Symbol name, const NativeFunction& function); // calls to the extern function with this name go to the native function
+	Variable CallFunction(Symbol name, const std::vector<Variable>& arguments); // lets native functions call back into the script
+
+	// runs instructions from instructionPointer up to end, returns true if it stopped at a yield, instructionPointer is then the instruction after it
+	bool ExecuteUntilYield(std::vector<Instruction>& instructions, size_t& instructionPointer, size_t end = SIZE_MAX);
+	// runs a generator function until its next yield, in between the frame and the instruction pointer keep where it stopped, both start out empty
+	// returns false once the function returned instead, the yielded value is in %frv, the arguments are only used when it starts
+	bool ResumeGenerator(Symbol name, const std::vector<Variable>& arguments, StackFrame& frame, size_t& instructionPointer);
+
+	template<typename T> T FindVariable(VariableInfo& info)
 	{
 		return (T)*FindVariable(info.name);
 	}
 
 private:
-	static void DeclareCacheVariable(const VariableInfo& info);
-
-	static Scope cacheVariables;
+	void DeclareCacheVariable(const VariableInfo& info);
+	void CallNativeFunction(const NativeFunction& function);
+	void RunParallelFor(Symbol loopVariable, int begin, int end, std::vector<Instruction>& instructions, size_t bodyBegin, size_t bodyEnd);
 
-	static std::unordered_map<std::string, Function*> functions;
-	static std::unordered_map<std::string, std::vector<Variable>> buffers;
-	static Stack stack;
+	ScriptContext& context;
+	Scope cacheVariables;
+	std::unordered_map<Symbol, std::vector<Variable>> buffers;
+	Stack stack;
+	const bool treatVoidAsError; // of the script, read for every variable
 };
\ No newline at end of file
@@ -1,132 +1,227 @@
+#include <cstring>
 #include "Lexer.hpp"
+#include "Scanner.hpp"
 
-std::unordered_map<std::string, LexicalToken> Lexer::stringToLexicalToken =
+struct ReservedWord
 {
-	{ "=",      LEXER_TOKEN_OPERATOR  }, { "-",      LEXER_TOKEN_OPERATOR  }, { "+",       LEXER_TOKEN_OPERATOR  }, { "/",      LEXER_TOKEN_OPERATOR  }, { "*",    LEXER_TOKEN_OPERATOR  },
-	{ "-=",     LEXER_TOKEN_OPERATOR  }, { "+=",     LEXER_TOKEN_OPERATOR  }, { "/=",      LEXER_TOKEN_OPERATOR  }, { "*=",     LEXER_TOKEN_OPERATOR  }, { "==",   LEXER_TOKEN_OPERATOR  },
-	{ " ",      LEXER_TOKEN_SEPERATOR }, { ";",      LEXER_TOKEN_SEPERATOR }, { ".",       LEXER_TOKEN_SEPERATOR }, { ",",      LEXER_TOKEN_SEPERATOR }, { "\n",   LEXER_TOKEN_SEPERATOR },
-	{ "{",      LEXER_TOKEN_SEPERATOR }, { "}",      LEXER_TOKEN_SEPERATOR }, { "(",       LEXER_TOKEN_SEPERATOR }, { ")",      LEXER_TOKEN_SEPERATOR }, { "!=",   LEXER_TOKEN_OPERATOR  },
-	{ "float",  LEXER_TOKEN_DATATYPE  }, { "int",    LEXER_TOKEN_DATATYPE  }, { "char",    LEXER_TOKEN_DATATYPE  }, { "struct", LEXER_TOKEN_DATATYPE  }, { "void", LEXER_TOKEN_DATATYPE  },
-	{ "return", LEXER_TOKEN_KEYWORD   }, { "extern", LEXER_TOKEN_KEYWORD   }, { "string",  LEXER_TOKEN_DATATYPE  }, { "import", LEXER_TOKEN_KEYWORD   }, { "if",   LEXER_TOKEN_KEYWORD   },
-	{ "while",  LEXER_TOKEN_KEYWORD   }, { ">",      LEXER_TOKEN_OPERATOR  }, { "<",       LEXER_TOKEN_OPERATOR  }, { ">=",     LEXER_TOKEN_OPERATOR  }, { "<=",   LEXER_TOKEN_OPERATOR  },
-	{ "for",    LEXER_TOKEN_KEYWORD   }, { "[",      LEXER_TOKEN_OPERATOR  }, { "]",       LEXER_TOKEN_OPERATOR  }, { "++",     LEXER_TOKEN_OPERATOR  }, { "--",   LEXER_TOKEN_OPERATOR  },
-	{ "&",      LEXER_TOKEN_OPERATOR  }, { "uint64", LEXER_TOKEN_DATATYPE  }, { "typedef", LEXER_TOKEN_KEYWORD   }, { "memory", LEXER_TOKEN_DATATYPE  }
+	LexicalToken token = LEXER_TOKEN_IDENTIFIER;
+	Lexeme lexeme = LEXEME_IDENTIFIER;
 };
 
-std::unordered_map<std::string, Lexeme> Lexer::stringToLexeme =
+// every keyword, datatype, seperator and operator is found by switching on its length and first character, so classifying a token costs at most one short compare
+// anything that is not reserved is an identifier
+constexpr ReservedWord GetReservedWord(std::string_view item)
 {
-	{ "-",      LEXEME_MINUS           }, { "+",      LEXEME_PLUS           }, { "*",      LEXEME_MULTIPLY        }, { "/",      LEXEME_DIVIDE           }, { "=",      LEXEME_EQUALS            },
-	{ "-=",     LEXEME_MINUSEQUALS     }, { "+=",     LEXEME_PLUSEQUALS     }, { "*=",     LEXEME_MULTIPLYEQUALS  }, { "/=",     LEXEME_DIVIDEEQUALS     }, { "==",     LEXEME_IS                },
-	{ " ",      LEXEME_WHITESPACE      }, { "",       LEXEME_WHITESPACE     }, { ";",      LEXEME_ENDLINE         }, { "(",      LEXEME_OPEN_PARENTHESIS }, { ")",      LEXEME_CLOSE_PARENTHESIS },
-	{ "{",      LEXEME_OPEN_CBRACKET   }, { "}",      LEXEME_CLOSE_CBRACKET }, { "[",      LEXEME_OPEN_SBRACKET   }, { "]",      LEXEME_CLOSE_SBRACKET   }, { "!=",     LEXEME_ISNOT             },
-	{ "float",  LEXEME_DATATYPE_FLOAT  }, { "int",    LEXEME_DATATYPE_INT   }, { "char",   LEXEME_DATATYPE_CHAR   }, { "struct", LEXEME_STRUCT           }, { "void",   LEXEME_DATATYPE_VOID     },
-	{ ".",      LEXEME_DOT             }, { ",",      LEXEME_COMMA          }, { "\n",     LEXEME_NEWLINE         }, { "return", LEXEME_RETURN           }, { "extern", LEXEME_EXTERN            },
-	{ "string", LEXEME_DATATYPE_STRING }, { "import", LEXEME_IMPORT         }, { "if",     LEXEME_IF              }, { "while",  LEXEME_WHILE            }, { ">",      LEXEME_GREATER           }, 
-	{ "<",      LEXEME_LESS            }, { ">=",     LEXEME_IS_OR_GREATER  }, { "<=",     LEXEME_IS_OR_LESS      }, { "for",    LEXEME_FOR              }, { "++",     LEXEME_PLUSPLUS          },
-	{ "--",     LEXEME_MINUSMINUS      }, { "&",      LEXEME_AMPERSAND      }, { "uint64", LEXEME_DATATYPE_UINT64 }, { "typdef", LEXEME_TYPEDEF          }, { "memory", LEXEME_DATATYPE_UINT64   }
-};
-
-int Lexer::lineNumber = 1;
+	switch (item.size())
+	{
+	case 1:
+		switch (item[0])
+		{
+		case '=':  return { LEXER_TOKEN_OPERATOR,  LEXEME_EQUALS            };
+		case '-':  return { LEXER_TOKEN_OPERATOR,  LEXEME_MINUS             };
+		case '+':  return { LEXER_TOKEN_OPERATOR,  LEXEME_PLUS              };
+		case '/':  return { LEXER_TOKEN_OPERATOR,  LEXEME_DIVIDE            };
+		case '*':  return { LEXER_TOKEN_OPERATOR,  LEXEME_MULTIPLY          };
+		case '>':  return { LEXER_TOKEN_OPERATOR,  LEXEME_GREATER           };
+		case '<':  return { LEXER_TOKEN_OPERATOR,  LEXEME_LESS              };
+		case '[':  return { LEXER_TOKEN_OPERATOR,  LEXEME_OPEN_SBRACKET     };
+		case ']':  return { LEXER_TOKEN_OPERATOR,  LEXEME_CLOSE_SBRACKET    };
+		case '&':  return { LEXER_TOKEN_OPERATOR,  LEXEME_AMPERSAND         };
+		case ' ':  return { LEXER_TOKEN_SEPERATOR, LEXEME_WHITESPACE        };
+		case ';':  return { LEXER_TOKEN_SEPERATOR, LEXEME_ENDLINE           };
+		case '.':  return { LEXER_TOKEN_SEPERATOR, LEXEME_DOT               };
+		case ',':  return { LEXER_TOKEN_SEPERATOR, LEXEME_COMMA             };
+		case '\n': return { LEXER_TOKEN_SEPERATOR, LEXEME_NEWLINE           };
+		case '{':  return { LEXER_TOKEN_SEPERATOR, LEXEME_OPEN_CBRACKET     };
+		case '}':  return { LEXER_TOKEN_SEPERATOR, LEXEME_CLOSE_CBRACKET    };
+		case '(':  return { LEXER_TOKEN_SEPERATOR, LEXEME_OPEN_PARENTHESIS  };
+		case ')':  return { LEXER_TOKEN_SEPERATOR, LEXEME_CLOSE_PARENTHESIS };
+		}
+		break;
+	case 2:
+		if (item == "if")
+			return { LEXER_TOKEN_KEYWORD, LEXEME_IF };
+		if (item[1] == '=')
+		{
+			switch (item[0])
+			{
+			case '-': return { LEXER_TOKEN_OPERATOR, LEXEME_MINUSEQUALS    };
+			case '+': return { LEXER_TOKEN_OPERATOR, LEXEME_PLUSEQUALS     };
+			case '/': return { LEXER_TOKEN_OPERATOR, LEXEME_DIVIDEEQUALS   };
+			case '*': return { LEXER_TOKEN_OPERATOR, LEXEME_MULTIPLYEQUALS };
+			case '=': return { LEXER_TOKEN_OPERATOR, LEXEME_IS             };
+			case '!': return { LEXER_TOKEN_OPERATOR, LEXEME_ISNOT          };
+			case '>': return { LEXER_TOKEN_OPERATOR, LEXEME_IS_OR_GREATER  };
+			case '<': return { LEXER_TOKEN_OPERATOR, LEXEME_IS_OR_LESS     };
+			}
+		}
+		if (item == "++")
+			return { LEXER_TOKEN_OPERATOR, LEXEME_PLUSPLUS };
+		if (item == "--")
+			return { LEXER_TOKEN_OPERATOR, LEXEME_MINUSMINUS };
+		break;
+	case 3:
+		if (item == "int")
+			return { LEXER_TOKEN_DATATYPE, LEXEME_DATATYPE_INT };
+		if (item == "map")
+			return { LEXER_TOKEN_DATATYPE, LEXEME_DATATYPE_MAP };
+		if (item == "for")
+			return { LEXER_TOKEN_KEYWORD, LEXEME_FOR };
+		break;
+	case 4:
+		if (item == "void")
+			return { LEXER_TOKEN_DATATYPE, LEXEME_DATATYPE_VOID };
+		if (item == "char")
+			return { LEXER_TOKEN_DATATYPE, LEXEME_DATATYPE_CHAR };
+		break;
+	case 5:
+		if (item == "float")
+			return { LEXER_TOKEN_DATATYPE, LEXEME_DATATYPE_FLOAT };
+		if (item == "while")
+			return { LEXER_TOKEN_KEYWORD, LEXEME_WHILE };
+		if (item == "yield")
+			return { LEXER_TOKEN_KEYWORD, LEXEME_YIELD };
+		break;
+	case 6:
+		switch (item[0])
+		{
+		case 'r': if (item == "return") return { LEXER_TOKEN_KEYWORD,  LEXEME_RETURN          }; break;
+		case 'e': if (item == "extern") return { LEXER_TOKEN_KEYWORD,  LEXEME_EXTERN          }; break;
+		case 'i': if (item == "import") return { LEXER_TOKEN_KEYWORD,  LEXEME_IMPORT          }; break;
+		case 'u': if (item == "uint64") return { LEXER_TOKEN_DATATYPE, LEXEME_DATATYPE_UINT64 }; break;
+		case 'm': if (item == "memory") return { LEXER_TOKEN_DATATYPE, LEXEME_DATATYPE_UINT64 }; break;
+		case 's':
+			if (item == "string")
+				return { LEXER_TOKEN_DATATYPE, LEXEME_DATATYPE_STRING };
+			if (item == "struct")
+				return { LEXER_TOKEN_DATATYPE, LEXEME_STRUCT };
+			break;
+		}
+		break;
+	case 7:
+		if (item == "typedef")
+			return { LEXER_TOKEN_KEYWORD, LEXEME_TYPEDEF };
+		break;
+	case 8:
+		if (item == "parallel")
+			return { LEXER_TOKEN_KEYWORD, LEXEME_PARALLEL };
+		break;
+	}
+	return {};
+}
+static_assert(GetReservedWord("while").lexeme == LEXEME_WHILE && GetReservedWord("+=").lexeme == LEXEME_PLUSEQUALS && GetReservedWord("whilst").token == LEXER_TOKEN_IDENTIFIER);
 
-std::vector<Lexer::Token> Lexer::LexInput(std::string input)
+std::vector<Lexer::Token> Lexer::LexInput(std::string_view input)
 {
 	std::vector<Token> ret;
-	std::string processingString = EMPTY_STRING;
-	bool isInStringLiteral = false, isInCommentary = false;
-	for (int i = 0; i < input.size(); i++)
+	ret.reserve(input.size() / 4); // on average a token is a few characters long, reserving up front prevents most reallocations
+	int lineNumber = 1; // kept local so that several files can be lexed at the same time
+	size_t tokenBegin = 0, tokenLength = 0; // the token that is being processed is only tracked as a range inside the input, nothing gets copied until the parser needs it
+
+	auto FlushToken = [&]()
 	{
-		if (input[i] == '\n')
-			lineNumber++;
-		if (lineNumber)
-			lineNumber = lineNumber;
-		isInCommentary = isInCommentary ? input[i] == '\n' ? false : isInCommentary : input[i] == '#';
-		if (isInCommentary)
+		if (tokenLength != 0)
+			ret.push_back(CreateToken(input.substr(tokenBegin, tokenLength), lineNumber));
+		tokenLength = 0;
+	};
+
+	const char* data = input.data();
+	for (size_t i = 0; i < input.size(); i++)
+	{
+		switch (input[i])
+		{
+		case '#': // the whole comment is skipped at once, the newline that ends it is processed like any other seperator
+		{
+			const char* newline = (const char*)memchr(data + i, '\n', input.size() - i);
+			i = newline == nullptr ? input.size() : newline - data;
+			i--;
 			continue;
+		}
+		case '\"': // a string literal, including its quotes, is added to the token as a whole
+		{
+			const char* closingQuote = (const char*)memchr(data + i + 1, '\"', input.size() - i - 1);
+			size_t literalEnd = closingQuote == nullptr ? input.size() : closingQuote - data + 1;
+			lineNumber += (int)Scanner::CountNewlines(data + i, data + literalEnd);
+			if (tokenLength == 0)
+				tokenBegin = i;
+			tokenLength += literalEnd - i;
+			i = literalEnd - 1;
+			continue;
+		}
+		case '\n':
+			lineNumber++;
+			break;
+		}
 
-		isInStringLiteral = isInStringLiteral ? input[i] != '\"' : input[i] == '\"';
-		if ((!IsSeperator(input[i]) && !IsOperator(input[i])) || isInStringLiteral)
+		if (!IsSeperator(input[i]) && !IsOperator(input[i]))
 		{
-			processingString += input[i];
+			size_t tokenEnd = Scanner::FindNextSpecialCharacter(data + i, data + input.size()) - data; // skip over the rest of an identifier, keyword or number in blocks instead of per char
+			if (tokenLength == 0)
+				tokenBegin = i;
+			tokenLength += tokenEnd - i; // a token is always contiguous, since anything that interrupts it (comments included) ends on a seperator
+			i = tokenEnd - 1;
 			continue;
 		}
 
 		if (IsOperator(input[i]) && i != input.size() - 1)
 		{
-			if (!processingString.empty())
-				ret.push_back(CreateToken(processingString));
-			bool isLargeOperator = IsOperator(input[(size_t)i + 1]);
+			FlushToken();
+			bool isSquareBracket = input[i] == '[' || input[i] == ']' || input[i + 1] == '[' || input[i + 1] == ']'; // brackets are never part of a larger operator, "a[-1]" and "a[0]++" have to be split around them
+			bool isLargeOperator = IsOperator(input[i + 1]) && !isSquareBracket;
+			ret.push_back(CreateToken(input.substr(i, isLargeOperator ? 2 : 1), lineNumber));
 			if (isLargeOperator)
-			{
-				
-				std::string fullOperator = std::string{ input[i] } + std::string{ input[(size_t)i + 1] };
-				ret.push_back(CreateToken(fullOperator));
 				i++;
-			}
-			else
-				ret.push_back(CreateToken(std::string{ input[i] }));
-			processingString = EMPTY_STRING;
 			continue;
 		}
 
-		if (!processingString.empty())
-			ret.push_back(CreateToken(processingString));
+		FlushToken();
 		if (input[i] != ' ' && input[i] != '\n' && input[i] != '\r' && input[i] != '\t') // whitespace is used as a seperator for cases like "float var" but whitespace doesnt need to be processed, the other seperators do need to be processed
-			ret.push_back(CreateToken(std::string{ input[i] }));
-		processingString = EMPTY_STRING;
+			ret.push_back(CreateToken(input.substr(i, 1), lineNumber));
 	}
+	FlushToken();
 	return ret;
 }
 
-LexicalToken Lexer::GetLexicalToken(std::string item)
+Lexeme Lexer::GetLiteralLexeme(std::string_view item)
 {
-	if (item.empty())
-		return LEXER_TOKEN_INVALID;
-	if (IsDigitLiteral(item) || IsStringLiteral(item))
-		return LEXER_TOKEN_LITERAL;
-
-	return stringToLexicalToken.count(item) > 0 ? stringToLexicalToken[item] : LEXER_TOKEN_IDENTIFIER;
-}
+	if (item[0] == '\"' && item.back() == '\"') // any string literal starts and ends with a '"', this does not however check if there are any syntaxical errors
+		return LEXEME_LITERAL_STRING;
 
-Lexeme Lexer::GetLexeme(LexicalToken token, std::string item)
-{
-	switch (token)
+	size_t digitCount = 0, dotCount = 0;
+	for (size_t i = 0; i < item.size(); i++) // a number literal only has digits, a single '.' makes it a float and a leading '-' makes it negative
 	{
-	case LEXER_TOKEN_IDENTIFIER:
-		return LEXEME_IDENTIFIER;
-
-	case LEXER_TOKEN_KEYWORD:
-	case LEXER_TOKEN_SEPERATOR:
-	case LEXER_TOKEN_OPERATOR:
-	case LEXER_TOKEN_DATATYPE:
-		return stringToLexeme[item];
-
-	case LEXER_TOKEN_LITERAL:
-		if (IsCharLiteral(item))
-			return LEXEME_LITERAL_CHAR;
-		else if (IsStringLiteral(item))
-			return LEXEME_LITERAL_STRING;
-		else
-			return IsFloatLiteral(item) ? LEXEME_LITERAL_FLOAT : LEXEME_LITERAL_INT;
-
-	case LEXER_TOKEN_WHITESPACE:
-		return LEXEME_WHITESPACE;
+		if (item[i] == '.')
+			dotCount++;
+		else if (item[i] >= '0' && item[i] <= '9')
+			digitCount++;
+		else if (i != 0 || item[0] != '-')
+			return LEXEME_INVALID;
 	}
-	return LEXEME_INVALID;
+	if (digitCount == 0 || dotCount > 1) // "." and "1.2.3" are not numbers
+		return LEXEME_INVALID;
+	return dotCount == 1 ? LEXEME_LITERAL_FLOAT : LEXEME_LITERAL_INT;
 }
 
-Lexer::Token Lexer::CreateToken(std::string content)
+Lexer::Token Lexer::CreateToken(std::string_view content, int line)
 {
 	Token ret{};
 	ret.content = content;
-	ret.token = GetLexicalToken(content);
-	ret.lexeme = GetLexeme(ret.token, content);
-	ret.line = lineNumber;
+	ret.line = line;
 
-	if (ret.lexeme == LEXEME_LITERAL_STRING) // remove the "'s of a string literal
+	ret.lexeme = GetLiteralLexeme(content);
+	if (ret.lexeme == LEXEME_INVALID)
 	{
-		ret.content.erase(ret.content.begin());
-		ret.content.erase(ret.content.end() - 1);
+		ReservedWord word = GetReservedWord(content);
+		ret.token = word.token;
+		ret.lexeme = word.lexeme;
+		if (ret.token == LEXER_TOKEN_IDENTIFIER)
+			ret.symbol = SymbolTable::Intern(content);
 	}
+	else
+		ret.token = LEXER_TOKEN_LITERAL;
+
+	if (ret.lexeme == LEXEME_LITERAL_STRING) // remove the "'s of a string literal, the payload itself is only copied once the parser turns it into a value
+		ret.content = ret.content.substr(1, ret.content.size() - 2);
 
 	return ret;
 }
@@ -170,33 +265,6 @@ bool Lexer::IsOperator(char item)
 	return false;
 }
 
-bool Lexer::IsDigitLiteral(std::string item)
-{
-	for (int i = 0; i < item.size(); i++)                                  // check if there are any non-digit chars in the string, if there arent its a number literal
-	{                                                                      // i do not know if this counts a '.' or ',' is a digit, so this might not catch a float or double but that should be caught later on anyways
-		if (i == 0 && item[0] == '-' && item.size() > 1 || item[i] == '.') // a negative number starts with a '-' which is not a digit, so skip the digit check to pretend that the '-' never existed
-			continue;
-		if (!std::isdigit((unsigned char)item[i]))
-			return false;
-	}
-	return true;
-}
-
-bool Lexer::IsStringLiteral(std::string item)
-{
-	return item[0] == '\"' && item.back() == '\"';         // any string literal starts and ends with a '"', this does not however check if there are any syntaxical errors
-}
-
-bool Lexer::IsCharLiteral(std::string item)
-{
-	return item[0] == '\'' && item.back() == '\'';
-}
-
-bool Lexer::IsFloatLiteral(std::string item)
-{
-	return item.find('.') != std::string::npos;
-}
-
 std::string LexicalTokenToString(LexicalToken token)
 {
 	switch (token)
@@ -223,12 +291,15 @@ std::string LexemeToString(Lexeme value)
 	case LEXEME_DATATYPE_INT:      return "LEXEME_DATATYPE_INT";
 	case LEXEME_DATATYPE_STRING:   return "LEXEME_DATATYPE_STRING";
 	case LEXEME_DATATYPE_VOID:     return "LEXEME_DATATYPE_VOID";
+	case LEXEME_DATATYPE_MAP:      return "LEXEME_DATATYPE_MAP";
 	case LEXEME_IDENTIFIER:        return "LEXEME_IDENTIFIER";
 	case LEXEME_RETURN:            return "LEXEME_RETURN";
 	case LEXEME_EXTERN:            return "LEXEME_EXTERN";
 	case LEXEME_IF:                return "LEXEME_IF";
 	case LEXEME_WHILE:             return "LEXEME_WHILE";
 	case LEXEME_FOR:               return "LEXEME_FOR";
+	case LEXEME_PARALLEL:          return "LEXEME_PARALLEL";
+	case LEXEME_YIELD:             return "LEXEME_YIELD";
 	case LEXEME_IMPORT:            return "LEXEME_IMPORT";
 	case LEXEME_ENDLINE:           return "LEXEME_ENDLINE";
 	case LEXEME_NEWLINE:           return "LEXEME_NEWLINE";
@@ -1,6 +1,6 @@
 #pragma once
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 #include "common.hpp"
 
@@ -28,12 +28,15 @@ enum Lexeme
 	LEXEME_DATATYPE_STRING = DATA_TYPE_STRING,
 	LEXEME_DATATYPE_VOID = DATA_TYPE_VOID,
 	LEXEME_DATATYPE_UINT64 = DATA_TYPE_UINT64,
+	LEXEME_DATATYPE_MAP = DATA_TYPE_MAP,
 	LEXEME_IDENTIFIER,
 	LEXEME_RETURN,
 	LEXEME_EXTERN,
 	LEXEME_IF,
 	LEXEME_WHILE,
 	LEXEME_FOR,
+	LEXEME_PARALLEL,
+	LEXEME_YIELD,
 	LEXEME_IMPORT,
 	LEXEME_ENDLINE,
 	LEXEME_NEWLINE,
@@ -80,27 +83,19 @@ class Lexer
 public:
 	struct Token
 	{
-		std::string content = EMPTY_STRING;
+		std::string_view content = EMPTY_STRING; // a view into the source file, the source must outlive the token
+		Symbol symbol = SYMBOL_NONE;             // only set for identifiers
 		LexicalToken token = LEXER_TOKEN_INVALID;
 		Lexeme lexeme = LEXEME_INVALID;
 		int line = 0;
 	};
 
-	static std::vector<Token> LexInput(std::string input);
+	static std::vector<Token> LexInput(std::string_view input);
 
 private:
-	static LexicalToken GetLexicalToken(std::string item);
-	static Lexeme GetLexeme(LexicalToken token, std::string item);
-	static Token CreateToken(std::string content);
+	static Token CreateToken(std::string_view content, int line);
+	static Lexeme GetLiteralLexeme(std::string_view item); // returns LEXEME_INVALID if the item is not a literal
 
 	static bool IsSeperator(char item);
 	static bool IsOperator(char item);
-	static bool IsDigitLiteral(std::string item);
-	static bool IsStringLiteral(std::string item);
-	static bool IsCharLiteral(std::string item);
-	static bool IsFloatLiteral(std::string item);
-
-	static std::unordered_map<std::string, LexicalToken> stringToLexicalToken;
-	static std::unordered_map<std::string, Lexeme>       stringToLexeme;
-	static int lineNumber;
 };
\ No newline at end of file
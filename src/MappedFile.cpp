@@ -0,0 +1,123 @@
+#include <stdexcept>
+#include <utility>
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filePath) : path(filePath)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Failed to open file " + filePath);
+
+	LARGE_INTEGER fileSize{};
+	GetFileSizeEx(file, &fileSize);
+	fileHandle = file;
+	size = (size_t)fileSize.QuadPart;
+	if (size == 0) // an empty file cannot be mapped, but it is still valid input
+		return;
+
+	mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr)
+	{
+		Unmap();
+		throw std::runtime_error("Failed to map file " + filePath);
+	}
+	data = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+	int file = open(filePath.c_str(), O_RDONLY);
+	if (file == -1)
+		throw std::runtime_error("Failed to open file " + filePath);
+
+	struct stat fileInfo{};
+	fstat(file, &fileInfo);
+	size = (size_t)fileInfo.st_size;
+	if (size == 0)
+	{
+		close(file);
+		return;
+	}
+
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file); // the mapping keeps its own reference to the file
+	if (mapping != MAP_FAILED)
+	{
+		madvise(mapping, size, MADV_SEQUENTIAL); // the lexer reads the file front to back exactly once
+		data = (const char*)mapping;
+	}
+#endif
+	if (data == nullptr)
+	{
+		Unmap();
+		throw std::runtime_error("Failed to map file " + filePath);
+	}
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this == &other)
+		return *this;
+	Unmap();
+
+	path = std::move(other.path);
+	data = std::exchange(other.data, nullptr);
+	size = std::exchange(other.size, 0);
+#ifdef _WIN32
+	fileHandle = std::exchange(other.fileHandle, nullptr);
+	mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	Unmap();
+}
+
+void MappedFile::Unmap()
+{
+#ifdef _WIN32
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (mappingHandle != nullptr)
+		CloseHandle(mappingHandle);
+	if (fileHandle != nullptr)
+		CloseHandle(fileHandle);
+	mappingHandle = fileHandle = nullptr;
+#else
+	if (data != nullptr)
+		munmap((void*)data, size);
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+std::string_view MappedFile::View() const
+{
+	return data == nullptr ? std::string_view{} : std::string_view{ data, size };
+}
+
+const std::string& MappedFile::GetPath() const
+{
+	return path;
+}
+
+size_t MappedFile::Size() const
+{
+	return size;
+}
\ No newline at end of file
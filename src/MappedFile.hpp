@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// a read-only view of a file on disk that is mapped directly into memory instead of being copied into a buffer
+// the lexer creates its tokens as views into this memory, so a mapped file has to stay alive for as long as any of its tokens are used
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const std::string& filePath);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	~MappedFile();
+
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	std::string_view View() const;
+	const std::string& GetPath() const;
+	size_t Size() const;
+
+private:
+	void Unmap();
+
+	std::string path;
+	const char* data = nullptr;
+	size_t size = 0;
+
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <filesystem>
+#include <stdexcept>
+#include <algorithm>
+#include "ModuleGraph.hpp"
+#include "Parallel.hpp"
+#include "Behavior.hpp"
+
+enum ModuleState
+{
+	MODULE_STATE_UNVISITED,
+	MODULE_STATE_VISITING, // the module is on the current import path, reaching it again means there is a cycle
+	MODULE_STATE_SORTED,
+};
+
+inline std::string NormalizePath(std::string_view path) // "std/../std/io.script" and "std/io.script" are the same module
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+ModuleGraph::ModuleGraph(const Behavior& behavior, const std::string& entryPath, std::string_view entrySource) : behavior(behavior)
+{
+	Module& entry = modules.emplace_back();
+	entry.path = NormalizePath(entryPath);
+	entry.source = entrySource;
+	moduleIndices[entry.path] = 0;
+
+	for (size_t first = 0; first < modules.size();) // every round lexes the modules that the previous round discovered
+	{
+		size_t end = modules.size();
+		LexModules(first);
+		for (size_t i = first; i < end; i++)
+			ResolveImports(i);
+		first = end;
+	}
+	SortModules();
+}
+
+void ModuleGraph::LexModules(size_t first)
+{
+	auto LexModule = [&](size_t i)
+	{
+		Module& module = modules[first + i];
+		if (first + i != 0)
+		{
+			module.file = MappedFile(module.path);
+			module.source = module.file.View();
+		}
+		module.tokens = Lexer::LexInput(module.source);
+	};
+
+	if (behavior.parseMultithreaded)
+		Parallel::For(modules.size() - first, LexModule);
+	else
+		for (size_t i = 0; i < modules.size() - first; i++)
+			LexModule(i);
+}
+
+void ModuleGraph::ResolveImports(size_t module)
+{
+	std::vector<Lexer::Token> tokens;
+	tokens.reserve(modules[module].tokens.size());
+	for (size_t i = 0; i < modules[module].tokens.size(); i++)
+	{
+		const Lexer::Token& token = modules[module].tokens[i];
+		if (token.lexeme != LEXEME_IMPORT)
+		{
+			tokens.push_back(token);
+			continue;
+		}
+		if (i + 1 >= modules[module].tokens.size() || modules[module].tokens[i + 1].lexeme != LEXEME_LITERAL_STRING)
+			throw std::runtime_error("Syntax error at line " + std::to_string(token.line) + " of " + modules[module].path + ": expected a file after import");
+
+		std::string path = NormalizePath(modules[module].tokens[i + 1].content);
+		i++; // the import statement is not part of the tokens of the module
+
+		auto [it, isNew] = moduleIndices.try_emplace(path, modules.size());
+		modules[module].imports.push_back(it->second);
+		if (!isNew)
+			continue;
+
+		modules.emplace_back().path = path; // this can move the modules, so nothing may refer to them across this line
+		if (behavior.verbose)
+			std::cout << "Successfully imported file at " << path << "\n";
+	}
+	modules[module].tokens = std::move(tokens);
+}
+
+void ModuleGraph::SortModules()
+{
+	std::vector<int> states(modules.size(), MODULE_STATE_UNVISITED);
+	std::vector<size_t> path;
+	SortModule(0, states, path);
+}
+
+void ModuleGraph::SortModule(size_t module, std::vector<int>& states, std::vector<size_t>& path)
+{
+	path.push_back(module);
+	if (states[module] == MODULE_STATE_VISITING)
+	{
+		std::string cycle;
+		for (size_t i = std::find(path.begin(), path.end(), module) - path.begin(); i < path.size(); i++)
+			cycle += (cycle.empty() ? "" : " -> ") + modules[path[i]].path;
+		throw std::runtime_error("Import cycle: " + cycle);
+	}
+
+	if (states[module] == MODULE_STATE_UNVISITED)
+	{
+		states[module] = MODULE_STATE_VISITING;
+		for (size_t import : modules[module].imports)
+			SortModule(import, states, path);
+		states[module] = MODULE_STATE_SORTED;
+		importOrder.push_back(module); // all of its imports are already in the order
+	}
+	path.pop_back();
+}
+
+std::vector<TokenSpan> ModuleGraph::GetTokensInImportOrder() const
+{
+	std::vector<TokenSpan> ret;
+	for (size_t module : importOrder)
+		ret.push_back(modules[module].tokens);
+	return ret;
+}
+
+std::vector<std::string> ModuleGraph::GetImportedFiles() const
+{
+	std::vector<std::string> ret;
+	for (size_t module : importOrder)
+		if (module != 0)
+			ret.push_back(modules[module].path);
+	return ret;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "MappedFile.hpp"
+#include "Behavior.hpp"
+
+struct Module
+{
+	std::string path;
+	MappedFile file; // not used by the entry module, its source is mapped by whoever created the graph
+	std::string_view source;
+	std::vector<Lexer::Token> tokens; // the import statements are left out
+	std::vector<size_t> imports;      // indices into the modules of the graph
+};
+
+// the input file and every file it imports, directly or through other imports
+// a file is lexed only once no matter how often it is imported, and files that are discovered together are lexed at the same time with -parse_multithreaded
+// the tokens of the modules have to outlive every function that is compiled from them
+class ModuleGraph
+{
+public:
+	ModuleGraph(const Behavior& behavior, const std::string& entryPath, std::string_view entrySource);
+
+	std::vector<TokenSpan> GetTokensInImportOrder() const; // a module always comes after the modules it imports, the entry module is last
+	std::vector<std::string> GetImportedFiles() const;     // in import order, without the entry module
+
+private:
+	void LexModules(size_t first); // lexes every module from first onwards
+	void ResolveImports(size_t module);
+	void SortModules(); // throws if modules import each other in a cycle
+	void SortModule(size_t module, std::vector<int>& states, std::vector<size_t>& path);
+
+	const Behavior& behavior; // of the script that imports the modules
+	std::vector<Module> modules;
+	std::vector<size_t> importOrder;
+	std::unordered_map<std::string, size_t> moduleIndices; // the normalized paths of all modules
+};
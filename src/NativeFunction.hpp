@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "common.hpp"
+
+class ScriptContext;
+
+// a C++ function that scripts call through an extern declaration
+// the arguments are read straight from the variables that the caller pushed, and the result is written straight into the return register
+// the context of the calling script is handed to every thunk, a function that works on the files, generators or other state of the script takes it as its first parameter
+struct NativeFunction
+{
+	using Thunk = void(*)(void(*function)(), ScriptContext& context, Variable* arguments, Variable& result);
+
+	std::string_view name;
+	void(*function)() = nullptr; // the bound function, the thunk casts it back to its real type
+	Thunk thunk = nullptr;
+	size_t parameterCount = 0;
+};
+
+template<typename T> inline decltype(auto) GetNativeArgument(Variable& argument) // a string_view argument refers to the pushed variable, so it is only valid during the call
+{
+	if constexpr (std::is_same_v<T, Variable>)
+		return (argument);
+	else if constexpr (std::is_same_v<T, std::string_view>)
+		return argument.GetStringView();
+	else if constexpr (std::is_same_v<T, std::string>)
+		return (std::string)argument;
+	else
+		return (T)argument;
+}
+
+template<typename T> inline Variable ToNativeResult(T value)
+{
+	if constexpr (std::is_same_v<T, bool>)
+		return Variable((int)value);
+	else if constexpr (std::is_same_v<T, std::string_view>)
+		return Variable(std::string(value));
+	else
+		return Variable(std::move(value));
+}
+
+template<typename R, typename... Args, size_t... I> inline void CallNativeFunction(R(*function)(Args...), Variable* arguments, Variable& result, std::index_sequence<I...>)
+{
+	if constexpr (std::is_void_v<R>)
+		function(GetNativeArgument<std::decay_t<Args>>(arguments[I])...);
+	else
+		result = ToNativeResult(function(GetNativeArgument<std::decay_t<Args>>(arguments[I])...));
+}
+
+template<typename R, typename... Args, size_t... I> inline void CallNativeFunction(R(*function)(ScriptContext&, Args...), ScriptContext& context, Variable* arguments, Variable& result, std::index_sequence<I...>)
+{
+	if constexpr (std::is_void_v<R>)
+		function(context, GetNativeArgument<std::decay_t<Args>>(arguments[I])...);
+	else
+		result = ToNativeResult(function(context, GetNativeArgument<std::decay_t<Args>>(arguments[I])...));
+}
+
+// the parameters can be int, float, char, uint64_t, std::string, std::string_view or Variable (to get the pushed variable itself),
+// the result can be void, bool (returned as an int) or anything that a Variable can be created from
+template<typename R, typename... Args> inline NativeFunction Bind(std::string_view name, R(*function)(Args...))
+{
+	NativeFunction ret;
+	ret.name = name;
+	ret.function = (void(*)())function;
+	ret.thunk = [](void(*function)(), ScriptContext&, Variable* arguments, Variable& result)
+	{
+		CallNativeFunction((R(*)(Args...))function, arguments, result, std::index_sequence_for<Args...>{});
+	};
+	ret.parameterCount = sizeof...(Args);
+	return ret;
+}
+
+template<typename R, typename... Args> inline NativeFunction Bind(std::string_view name, R(*function)(ScriptContext&, Args...)) // the context is not one of the parameters that the script declares
+{
+	NativeFunction ret;
+	ret.name = name;
+	ret.function = (void(*)())function;
+	ret.thunk = [](void(*function)(), ScriptContext& context, Variable* arguments, Variable& result)
+	{
+		CallNativeFunction((R(*)(ScriptContext&, Args...))function, context, arguments, result, std::index_sequence_for<Args...>{});
+	};
+	ret.parameterCount = sizeof...(Args);
+	return ret;
+}
@@ -0,0 +1,57 @@
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include "Output.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#define IsTerminal(file) _isatty(_fileno(file))
+#else
+#include <unistd.h>
+#define IsTerminal(file) isatty(fileno(file))
+#endif
+
+constexpr size_t OUTPUT_BUFFER_SIZE = 1 << 16;
+
+inline void WriteToStdout(std::string_view text) // std::cout is synchronized with stdout, so output from both stays in order
+{
+	std::fwrite(text.data(), 1, text.size(), stdout);
+	std::fflush(stdout);
+}
+
+Output::Output(OutputBuffering buffering) : buffer(std::make_unique<char[]>(OUTPUT_BUFFER_SIZE))
+{
+	isLineBuffered = buffering == OUTPUT_BUFFERING_LINE || (buffering == OUTPUT_BUFFERING_AUTO && IsTerminal(stdout));
+}
+
+Output::~Output()
+{
+	Flush();
+}
+
+void Output::Write(std::string_view text)
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	if (bufferedSize + text.size() > OUTPUT_BUFFER_SIZE)
+		Flush();
+
+	if (text.size() >= OUTPUT_BUFFER_SIZE) // copying text this large into the buffer first would not save any writes
+		WriteToStdout(text);
+	else
+	{
+		memcpy(buffer.get() + bufferedSize, text.data(), text.size());
+		bufferedSize += text.size();
+	}
+
+	if (isLineBuffered && memchr(text.data(), '\n', text.size()) != nullptr)
+		Flush();
+}
+
+void Output::Flush()
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	if (bufferedSize == 0)
+		return;
+	WriteToStdout({ buffer.get(), bufferedSize });
+	bufferedSize = 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include "Behavior.hpp"
+
+// everything that a script writes goes through one large buffer instead of through std::cout per call
+// the buffer is flushed when it is full, when the script ends, before input is read and when the script calls Flush()
+// when the output is line buffered (the default for a terminal, see -output_buffering) it is also flushed after every newline
+// every ScriptContext has its own buffer, scripts that run at the same time only mix their output at the points where it is flushed
+class Output
+{
+public:
+	Output(OutputBuffering buffering);
+	Output(const Output&) = delete;
+	Output& operator=(const Output&) = delete;
+	~Output();
+
+	void Write(std::string_view text);
+	void Flush();
+
+private:
+	std::unique_ptr<char[]> buffer;
+	size_t bufferedSize = 0;
+	bool isLineBuffered;
+	std::recursive_mutex mutex; // the threads of a parallel for write to the same buffer, Write calls Flush while holding it
+};
@@ -0,0 +1,204 @@
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+#include "Parallel.hpp"
+#include "ScriptContext.hpp"
+
+constexpr size_t MAX_WORKER_COUNT = 1 << 10; // the pool grows past one thread per core while iterations wait for channels
+
+struct ParallelJob // one call to For, shared so that a worker that took the last index can still touch it after the caller returned
+{
+	size_t count;
+	const std::function<void(size_t)>* task;
+	ScriptContext* context;
+	std::atomic<size_t> nextIndex = 0;
+	std::atomic<size_t> finishedCount = 0;
+	std::vector<std::exception_ptr> errors;
+	std::mutex mutex; // without a context, the caller waits on these, with one it waits like a thread that waits for a channel
+	std::condition_variable finished;
+	bool isCallerWaiting = false; // guarded by the waitMutex of the context
+	size_t workerCount = 0;       // the workers that took the job, guarded by mutex
+};
+
+// the workers are started the first time they are needed and then wait for the next job, instead of starting threads for every loop
+// a job is taken by as many workers as are idle, a worker that runs a nested For adds that job and helps with it like any caller would
+class WorkerPool
+{
+public:
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			isStopping = true;
+		}
+		jobAdded.notify_all();
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	void Run(const std::shared_ptr<ParallelJob>& job, size_t helperCount)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			while (workers.size() < helperCount)
+				workers.emplace_back([this]() { Work(); });
+			jobs.push_back(job);
+		}
+		for (size_t i = 0; i < helperCount; i++)
+			jobAdded.notify_one();
+
+		RunRemainingTasks(*job); // the calling thread helps instead of waiting
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.erase(std::remove(jobs.begin(), jobs.end(), job), jobs.end());
+		}
+		if (job->context != nullptr)
+		{
+			// the caller counts as waiting, so that iterations that wait for each other through channels are found to wait forever
+			// the thread that finishes the last task ends the wait, before it stops counting as a thread of the script itself
+			ScriptContext& context = *job->context;
+			std::unique_lock<std::mutex> lock(context.waitMutex);
+			if (job->finishedCount < job->count)
+			{
+				job->isCallerWaiting = true;
+				context.BeginWait();
+				context.waitChanged.wait(lock, [&]() { return !job->isCallerWaiting; });
+			}
+		}
+		std::unique_lock<std::mutex> lock(job->mutex); // the script can end after this, so the workers must be done with its context
+		job->finished.wait(lock, [&]() { return job->finishedCount == job->count && job->workerCount == 0; });
+	}
+
+	bool HasUnstartedTasks(ScriptContext* context)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return HasUnclaimedJob(context);
+	}
+
+	void StartHelper(ScriptContext* context)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!HasUnclaimedJob(context))
+			return;
+		if (idleWorkerCount == 0)
+		{
+			if (workers.size() >= MAX_WORKER_COUNT)
+				throw std::runtime_error("Cannot start another thread for the waiting iterations of a parallel for, " + std::to_string(MAX_WORKER_COUNT) + " threads already run");
+			workers.emplace_back([this]() { Work(); });
+		}
+		jobAdded.notify_all();
+	}
+
+private:
+	static void RunRemainingTasks(ParallelJob& job)
+	{
+		for (size_t i = job.nextIndex++; i < job.count; i = job.nextIndex++)
+		{
+			try
+			{
+				(*job.task)(i);
+			}
+			catch (...)
+			{
+				job.errors[i] = std::current_exception();
+			}
+			if (++job.finishedCount < job.count)
+				continue;
+			if (job.context == nullptr)
+			{
+				std::lock_guard<std::mutex> lock(job.mutex); // the caller cannot miss the notification between checking the count and waiting
+				job.finished.notify_all();
+			}
+			else
+			{
+				std::lock_guard<std::mutex> lock(job.context->waitMutex);
+				if (job.isCallerWaiting)
+				{
+					job.isCallerWaiting = false;
+					job.context->EndWait();
+				}
+				job.context->waitChanged.notify_all();
+			}
+		}
+	}
+
+	void Work()
+	{
+		while (true)
+		{
+			std::shared_ptr<ParallelJob> job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				idleWorkerCount++;
+				jobAdded.wait(lock, [&]() { return isStopping || HasUnclaimedJob(nullptr); });
+				idleWorkerCount--;
+				if (isStopping)
+					return;
+				for (const std::shared_ptr<ParallelJob>& candidate : jobs)
+					if (candidate->nextIndex < candidate->count)
+						job = candidate;
+			}
+			{
+				std::lock_guard<std::mutex> lock(job->mutex); // the caller could have taken the last index since, then it may not wait for this worker
+				if (job->nextIndex >= job->count)
+					continue;
+				job->workerCount++;
+			}
+			{
+				ScriptContext::Binding binding(job->context); // the tasks work on the same script as the calling thread
+				RunRemainingTasks(*job);
+			}
+			std::lock_guard<std::mutex> lock(job->mutex);
+			job->workerCount--;
+			job->finished.notify_all();
+		}
+	}
+
+	bool HasUnclaimedJob(ScriptContext* context) const // of any script if context is nullptr
+	{
+		return std::any_of(jobs.begin(), jobs.end(), [&](const std::shared_ptr<ParallelJob>& job) { return (context == nullptr || job->context == context) && job->nextIndex < job->count; });
+	}
+
+	std::mutex mutex;
+	std::condition_variable jobAdded;
+	std::vector<std::shared_ptr<ParallelJob>> jobs; // the newest job is taken first, it is the most nested one
+	std::vector<std::thread> workers;
+	size_t idleWorkerCount = 0;
+	bool isStopping = false;
+};
+
+static WorkerPool pool;
+
+bool Parallel::HasUnstartedTasks(ScriptContext* context)
+{
+	return pool.HasUnstartedTasks(context);
+}
+
+void Parallel::StartHelper(ScriptContext* context)
+{
+	pool.StartHelper(context);
+}
+
+void Parallel::For(size_t count, const std::function<void(size_t)>& task)
+{
+	if (count == 0)
+		return;
+
+	std::shared_ptr<ParallelJob> job = std::make_shared<ParallelJob>();
+	job->count = count;
+	job->task = &task;
+	job->context = ScriptContext::Find();
+	job->errors.resize(count);
+	pool.Run(job, std::min((size_t)std::max(std::thread::hardware_concurrency(), 1u), count) - 1);
+
+	for (std::exception_ptr& error : job->errors)
+		if (error != nullptr)
+			std::rethrow_exception(error);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+class ScriptContext;
+
+namespace Parallel
+{
+	// calls task for every index in [0, count) on one thread per core, the calling thread helps instead of waiting
+	// the other threads are kept in a pool between calls and can run tasks of other scripts in between, so a task keeps its state in the ScriptContext and not in the thread
+	// tasks can differ a lot in size, so every thread takes the next index when it is done instead of a fixed share
+	// if tasks throw, the exception of the lowest index is rethrown after all tasks are done, like a sequential loop would report it
+	// the threads work on the ScriptContext of the calling thread
+	inline extern void For(size_t count, const std::function<void(size_t)>& task);
+
+	// for a thread that is about to wait for another thread of the script, the tasks of the script that no thread took yet could be the ones it waits for
+	inline extern bool HasUnstartedTasks(ScriptContext* context);
+	inline extern void StartHelper(ScriptContext* context); // gets those tasks a thread, starting one if the pool has none left
+}
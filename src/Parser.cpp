@@ -1,32 +1,28 @@
 #include <unordered_map>
+#include <algorithm>
 #include <stdexcept>
 #include "Parser.hpp"
 #include "Interpreter.hpp"
 #include "Behavior.hpp"
 #include "common.hpp"
 #include "Optimizer.hpp"
+#include "ScriptContext.hpp"
+#include "Parallel.hpp"
 
-StackFrame Parser::simulationStackFrame;
-std::unordered_map<std::string, FunctionInfo> Parser::functionInfos;
-std::unordered_set<std::string> Parser::calledFunctions;
-
-inline size_t GetNextInstanceOfLexeme(Lexeme lexeme, size_t index, const std::vector<Lexer::Token>& tokens)
+Parser::Parser(ScriptContext& context) : context(context)
 {
-	for (; index < tokens.size(); index++)
-		if (tokens[index].lexeme == lexeme)
-			return index;
-	return 0;
+	simulationStackFrame.isDumped = context.behavior.dumpStackFrame;
 }
 
-inline size_t GetNextInstanceOfLexicalToken(LexicalToken token, size_t index, const std::vector<Lexer::Token>& tokens)
+inline size_t GetNextInstanceOfLexeme(Lexeme lexeme, size_t index, TokenSpan tokens)
 {
 	for (; index < tokens.size(); index++)
-		if (tokens[index].token == token)
+		if (tokens[index].lexeme == lexeme)
 			return index;
 	return 0;
 }
 
-inline size_t GetIndexOfClosingCBracket(size_t index, const std::vector<Lexer::Token>& tokens)
+inline size_t GetIndexOfClosingCBracket(size_t index, TokenSpan tokens)
 {
 	int timesReferenced = 0;
 	for (; index < tokens.size(); index++) // this relies on the fact that the tokens vector starts on the opening cbracket
@@ -78,9 +74,43 @@ inline DataType LexemeLiteralToDataType(Lexeme lexeme)
 	return DATA_TYPE_INVALID;
 }
 
-std::vector<FunctionInfo> Parser::GetAllFunctionInfos(std::vector<Lexer::Token>& tokens)
+inline uint64_t HashTokens(TokenSpan tokens, uint64_t hash = HashContent({})) // line numbers are left out, so moving a function around does not change its hash
+{
+	for (const Lexer::Token& token : tokens)
+	{
+		hash = HashContent(std::string_view((const char*)&token.lexeme, sizeof(token.lexeme)), hash);
+		hash = HashContent(token.content, hash);
+	}
+	return hash;
+}
+
+inline bool CompilesBodiesUpFront(const Behavior& behavior) // only needed when the instructions are dumped, when the unused functions have to be known, when the bodies are compiled in parallel or when they are cached
+{
+	return behavior.dumpFunctionInstructions || behavior.dumpStackFrame || behavior.removeUnusedSymbols || behavior.parseMultithreaded || behavior.bytecodeCache;
+}
+
+std::vector<FunctionInfo> Parser::GetAllFunctionInfos(ScriptContext& context, TokenSpan tokens)
+{
+	return GetAllFunctionInfos(context, std::vector<TokenSpan>{ tokens });
+}
+
+std::vector<FunctionInfo> Parser::GetAllFunctionInfos(ScriptContext& context, const std::vector<TokenSpan>& modules)
 {
 	std::vector<FunctionInfo> ret;
+	for (TokenSpan tokens : modules) // all signatures are collected first, so that every body can see every function of every module while they are compiled
+		CollectFunctionSignatures(context, tokens, ret);
+
+	if (!CompilesBodiesUpFront(context.behavior)) // the bodies get compiled when they are first called, so code that never runs costs nothing
+		return ret;
+
+	CompileFunctionBodies(context, ret);
+	return ret;
+}
+
+void Parser::CollectFunctionSignatures(ScriptContext& context, TokenSpan tokens, std::vector<FunctionInfo>& ret)
+{
+	CheckOpenCloseIntegrityPremature(tokens);
+
 	bool isExtern = false;
 	for (size_t i = 0; i < tokens.size(); i++)
 	{
@@ -95,325 +125,694 @@ std::vector<FunctionInfo> Parser::GetAllFunctionInfos(std::vector<Lexer::Token>&
 		case LEXEME_DATATYPE_INT:
 		case LEXEME_DATATYPE_VOID:
 		case LEXEME_DATATYPE_STRING:
+		case LEXEME_DATATYPE_MAP:
 			if (tokens[i + 2].lexeme == LEXEME_EQUALS || tokens[i + 2].lexeme == LEXEME_ENDLINE) // a var is declared with either "float var = ..." or "float var;", while a function is not
 				break;
 
 			size_t cParenIndex = GetNextInstanceOfLexeme(LEXEME_CLOSE_PARENTHESIS, i, tokens);
-			std::vector<Lexer::Token> declarationTokens = { tokens.begin() + i, tokens.begin() + cParenIndex + 1 };
-			FunctionInfo functionInfo = GetFunctionInfoFromTokens(declarationTokens);
-			
+			FunctionInfo functionInfo = GetFunctionInfoFromTokens(tokens.subspan(i, cParenIndex + 1 - i));
+			if (context.behavior.bytecodeCache)
+				functionInfo.signatureHash = HashTokens(tokens.subspan(i, cParenIndex + 1 - i));
+
 			if (isExtern)
 			{
 				i = cParenIndex + 1;
-				ret.push_back(functionInfo);
-				functionInfos[functionInfo.name] = functionInfo;
 				isExtern = false;
-				break;
 			}
-			for (int j = 0; j < functionInfo.parameters.size(); j++)
-				simulationStackFrame.Allocate(functionInfo.parameters[j]);
-
-			size_t cBracketIndex = GetIndexOfClosingCBracket(cParenIndex + 1, tokens);
-			std::vector<Lexer::Token> bodyTokens = { tokens.begin() + cParenIndex + 2, tokens.begin() + cBracketIndex };
-			std::vector<std::vector<Lexer::Token>> test = GetAllScopesFromBody(bodyTokens);
-			functionInfo.instructions = GetInstructionsFromScopes(test);
-			Optimizer::OptimizeInstructions(functionInfo.instructions);
-			simulationStackFrame.Clear();
-			i = cBracketIndex;
-
+			else
+			{
+				size_t cBracketIndex = GetIndexOfClosingCBracket(cParenIndex + 1, tokens);
+				functionInfo.body = tokens.subspan(cParenIndex + 2, cBracketIndex - cParenIndex - 2);
+				functionInfo.isCompiled = false;
+				if (context.behavior.bytecodeCache)
+					functionInfo.bodyHash = HashTokens(functionInfo.body, functionInfo.signatureHash);
+				i = cBracketIndex;
+			}
+			context.functionInfos[functionInfo.name] = functionInfo;
 			ret.push_back(functionInfo);
-			functionInfos[functionInfo.name] = functionInfo;
-			simulationStackFrame.Clear();
 			break;
 		}
 	}
-	return ret;
 }
 
-inline std::vector<Lexer::Token> GetTokensInsideParentheses(std::vector<Lexer::Token>& tokens, size_t& index)
+void Parser::CompileFunctionBodies(ScriptContext& context, std::vector<FunctionInfo>& infos)
 {
-	size_t parenReferenceCount = 0, beginIndex = index;
-	for (; index < tokens.size(); index++)
+	std::vector<FunctionInfo*> bodies; // extern functions do not have a body
+	size_t reusedCount = 0;
+	for (FunctionInfo& info : infos)
 	{
-		if (tokens[index].lexeme == LEXEME_OPEN_PARENTHESIS)
-			parenReferenceCount++;
-		else if (tokens[index].lexeme == LEXEME_CLOSE_PARENTHESIS)
-			parenReferenceCount--;
-		if (parenReferenceCount == 0)
-			return { tokens.begin() + beginIndex + 1, tokens.begin() + index };
+		if (info.isCompiled)
+			continue;
+		if (ReuseCompiledFunction(context, info))
+			reusedCount++;
+		else
+			bodies.push_back(&info);
 	}
-	return {};
+	if (context.behavior.verbose && !context.compiledFunctionCache.empty())
+		std::cout << "Reused the instructions of " << reusedCount << " functions, compiling the other " << bodies.size() << "\n";
+
+	if (context.behavior.parseMultithreaded && !context.behavior.dumpStackFrame) // dumped stack frames would interleave between threads
+		Parallel::For(bodies.size(), [&](size_t i) { CompileFunction(context, *bodies[i]); });
+	else
+		for (FunctionInfo* info : bodies)
+			CompileFunction(context, *info);
 }
 
-void Parser::GetFunctionPushInstructions(const std::vector<Lexer::Token>& tokens, size_t& index, std::vector<Instruction>& ret)
+void Parser::CompileFunction(ScriptContext& context, FunctionInfo& info)
 {
-	Instruction pushInst{};
-	pushInst.type = INSTRUCTION_TYPE_PUSH;
-	pushInst.operand1 = bufferParametersVar;
-	int oParenReferenceCount = 0;
+	Parser parser(context);
+	parser.simulationStackFrame.Clear();
+	for (const VariableInfo& parameter : info.parameters)
+		parser.simulationStackFrame.Allocate(parameter);
+
+	info.instructions = parser.GetInstructionsFromFunctionBody(info.body);
+	Optimizer::OptimizeInstructions(info.instructions);
+	info.isCompiled = true;
+	if (info.bodyHash != 0)
+		info.dependencyHash = GetDependencyHash(context, info.instructions);
+	parser.simulationStackFrame.Clear();
+}
 
-	std::vector<Lexer::Token> paramTokens;
-	for (; index < tokens.size(); index++)
-	{
-		switch (tokens[index].lexeme)
-		{
-		case LEXEME_ENDLINE:
-			return;
+void Parser::AddToFunctionCache(ScriptContext& context, const std::vector<FunctionInfo>& infos)
+{
+	for (const FunctionInfo& info : infos)
+		if (info.bodyHash != 0 && info.isCompiled)
+			context.compiledFunctionCache[info.bodyHash] = info;
+}
 
-		case LEXEME_CLOSE_PARENTHESIS:
-			if (oParenReferenceCount != 0)
-				paramTokens.push_back(tokens[index]);
-			oParenReferenceCount--;
-			if (paramTokens.empty() || oParenReferenceCount > 0)
-				break;
-			[[fallthrough]];
-		case LEXEME_COMMA:
-		{
-			GetInstructionsFromRValueRecursive(paramTokens, ret, bufferParametersVar);
-			ret.back().type = INSTRUCTION_TYPE_PUSH;
-			paramTokens.clear();
-			break;
-		}
+bool Parser::ReuseCompiledFunction(ScriptContext& context, FunctionInfo& info)
+{
+	std::unordered_map<uint64_t, FunctionInfo>& compiledFunctionCache = context.compiledFunctionCache;
+	auto cached = compiledFunctionCache.find(info.bodyHash);
+	if (info.bodyHash == 0 || cached == compiledFunctionCache.end())
+		return false;
+	if (GetDependencyHash(context, cached->second.instructions) != cached->second.dependencyHash) // a function that it calls has a different signature now, so its calls have to be checked again
+		return false;
 
-		case LEXEME_OPEN_PARENTHESIS:
-			oParenReferenceCount++;
-			[[fallthrough]];
-		default:
-			paramTokens.push_back(tokens[index]);
-			break;
-		}
+	info.instructions = cached->second.instructions;
+	info.dependencyHash = cached->second.dependencyHash;
+	info.isCompiled = true;
+	return true;
+}
+
+uint64_t Parser::GetDependencyHash(ScriptContext& context, const std::vector<Instruction>& instructions)
+{
+	const std::unordered_map<Symbol, FunctionInfo>& functionInfos = context.functionInfos;
+	uint64_t ret = HashContent({});
+	for (const Instruction& instruction : instructions)
+	{
+		if (instruction.type != INSTRUCTION_TYPE_CALL)
+			continue;
+		auto callee = functionInfos.find(instruction.operand1.name);
+		uint64_t signatureHash = callee == functionInfos.end() ? 0 : callee->second.signatureHash;
+		ret = HashContent(std::string_view((const char*)&signatureHash, sizeof(signatureHash)), ret);
 	}
+	return ret;
 }
 
-void Parser::GetInstructionsFromRValueRecursive(std::vector<Lexer::Token>& tokens, std::vector<Instruction>& destination, const VariableInfo& varToWriteTo)
+inline int GetOperatorPrecedence(Lexeme op) // 0 means that the token does not continue the expression
 {
-	Instruction final{};
-	final.type = INSTRUCTION_TYPE_ASSIGN;
-	final.operand1 = floatCalculationVar;
+	switch (op)
+	{
+	case LEXEME_PLUS:
+	case LEXEME_MINUS:
+		return 1;
+	case LEXEME_MULTIPLY:
+	case LEXEME_DIVIDE:
+		return 2;
+	}
+	return 0;
+}
 
-	for (size_t i = 0; i < tokens.size(); i++)
+inline size_t GetIndexOfClosingSBracket(size_t index, TokenSpan tokens) // index is the '['
+{
+	for (size_t i = index, depth = 0; i < tokens.size(); i++)
 	{
-		switch (tokens[i].token)
-		{
-		case LEXER_TOKEN_SEPERATOR:
-		{
-			if (tokens[i].lexeme != LEXEME_OPEN_PARENTHESIS)
-				break;
-			if (tokens[i].lexeme == LEXEME_ENDLINE)
-			{
-				final = { INSTRUCTION_TYPE_ASSIGN, varToWriteTo };
-				break;
-			}
+		if (tokens[i].lexeme == LEXEME_OPEN_SBRACKET)
+			depth++;
+		else if (tokens[i].lexeme == LEXEME_CLOSE_SBRACKET && --depth == 0)
+			return i;
+	}
+	throw std::runtime_error("Syntax error at line " + std::to_string(tokens[index].line) + ": expected a ']'");
+}
 
-			int parenReferenceCount = 0;
-			std::vector<Lexer::Token> priorityTokens = GetTokensInsideParentheses(tokens, i);
-			GetInstructionsFromRValueRecursive(priorityTokens, destination, varToWriteTo);
-			destination.back().operand1 = floatCalculationVar;
-			break;
-		}
-		case LEXER_TOKEN_OPERATOR:
-			if ((tokens[i].lexeme == LEXEME_AMPERSAND || tokens[i].lexeme == LEXEME_MULTIPLY) && (i == 0 || tokens[i - 1].lexeme != LEXEME_IDENTIFIER))
-			{
-				if (tokens[i].lexeme == LEXEME_AMPERSAND)
-					ProcessLocationOfOperator(tokens, i, final);
-				else if (tokens[i].lexeme == LEXEME_MULTIPLY)
-					ProcessDereferenceOperator(tokens, i, final);
+inline void CheckIndexType(DataType containerType, DataType type, int line)
+{
+	if (containerType == DATA_TYPE_MAP && !DataTypeIsInt(type) && !DataTypeIsChar(type) && !DataTypeIsString(type) && type != DATA_TYPE_VOID)
+		throw std::runtime_error("Syntax error at line " + std::to_string(line) + ": a map key has to be an int or a string, not a " + DataTypeToInternalTypeString(type));
+	if (containerType != DATA_TYPE_MAP && !DataTypeIsInt(type) && !DataTypeIsChar(type) && type != DATA_TYPE_VOID)
+		throw std::runtime_error("Syntax error at line " + std::to_string(line) + ": an index has to be an int, not a " + DataTypeToInternalTypeString(type));
+}
 
-				destination.push_back(final);
-				final = { INSTRUCTION_TYPE_ASSIGN, floatCalculationVar };
-				break;
-			}
+inline bool IsInstructionCommutative(InstructionType type)
+{
+	return type == INSTRUCTION_TYPE_ADD || type == INSTRUCTION_TYPE_MULTIPLY;
+}
+
+inline bool IsInstructionComparison(InstructionType type)
+{
+	return type >= INSTRUCTION_TYPE_EQUAL && type <= INSTRUCTION_TYPE_EQUAL_OR_LESS;
+}
+
+inline VariableInfo GetCalculationRegisterChecked(size_t index, int line)
+{
+	if (index >= CALCULATION_REGISTER_COUNT)
+		throw std::runtime_error("Syntax error at line " + std::to_string(line) + ": the expression is too complex, it needs more than " + std::to_string(CALCULATION_REGISTER_COUNT) + " calculation registers");
+	return GetCalculationRegister(index);
+}
+
+inline const Lexer::Token& GetExpressionToken(TokenSpan tokens, size_t index)
+{
+	if (index >= tokens.size())
+		throw std::runtime_error("Syntax error at line " + std::to_string(tokens.empty() ? 0 : tokens.back().line) + ": the expression ends unexpectedly");
+	return tokens[index];
+}
 
-			final.type = GetInstructionTypeFromLexemeOperator(tokens[i].lexeme);
+inline bool ExpressionReadsVariableLate(const ExpressionTree& tree, uint32_t root, Symbol variable) // true if the variable is read after the leftmost value of the expression
+{
+	uint32_t leftmost = root;
+	while (tree.nodes[leftmost].type == EXPRESSION_NODE_BINARY)
+		leftmost = tree.nodes[leftmost].left;
+
+	for (uint32_t i = 0; i < tree.nodes.size(); i++)
+		if (i != leftmost && tree.nodes[i].type != EXPRESSION_NODE_CALL && tree.nodes[i].value.name == variable)
+			return true;
+	return tree.nodes[leftmost].type != EXPRESSION_NODE_VALUE && tree.nodes[leftmost].value.name == variable;
+}
+
+uint32_t Parser::ParseExpression(TokenSpan tokens, size_t& index, ExpressionTree& tree, int minimumPrecedence)
+{
+	uint32_t left = ParsePrimaryExpression(tokens, index, tree);
+	while (index < tokens.size())
+	{
+		int precedence = GetOperatorPrecedence(tokens[index].lexeme);
+		if (precedence < minimumPrecedence || precedence == 0)
 			break;
 
-		case LEXER_TOKEN_LITERAL:
+		const Lexer::Token& op = tokens[index++];
+		uint32_t right = ParseExpression(tokens, index, tree, precedence + 1); // all binary operators are left associative
+		left = CreateBinaryExpression(tree, op, left, right);
+	}
+	return left;
+}
+
+uint32_t Parser::ParsePrimaryExpression(TokenSpan tokens, size_t& index, ExpressionTree& tree)
+{
+	const Lexer::Token& token = GetExpressionToken(tokens, index++);
+	ExpressionNode node{};
+	node.line = token.line;
+
+	switch (token.lexeme)
+	{
+	case LEXEME_LITERAL_CHAR:
+	case LEXEME_LITERAL_FLOAT:
+	case LEXEME_LITERAL_INT:
+	case LEXEME_LITERAL_STRING:
+		node.value.dataType = LexemeLiteralToDataType(token.lexeme);
+		node.value.size = (uint32_t)Sizeof(node.value.dataType);
+		node.value.literalValue = token.content; // the literal only gets decoded from the source here
+		break;
+
+	case LEXEME_OPEN_PARENTHESIS:
+	{
+		uint32_t inner = ParseExpression(tokens, index, tree);
+		if (GetExpressionToken(tokens, index).lexeme != LEXEME_CLOSE_PARENTHESIS)
+			throw std::runtime_error("Syntax error at line " + std::to_string(token.line) + ": expected a ')'");
+		index++;
+		return inner;
+	}
+
+	case LEXEME_MINUS:
+	{
+		uint32_t operand = ParsePrimaryExpression(tokens, index, tree);
+		ExpressionNode& operandNode = tree.nodes[operand];
+		bool isNumber = DataTypeIsInt(operandNode.value.dataType) || DataTypeIsFloat(operandNode.value.dataType);
+		if (operandNode.type == EXPRESSION_NODE_VALUE && !operandNode.value.literalValue.empty() && isNumber) // negative literals dont need an instruction
 		{
-			final.operand2.dataType = LexemeLiteralToDataType(tokens[i].lexeme);
-			final.operand2.literalValue = tokens[i].content;
-			destination.push_back(final);
-			final = { INSTRUCTION_TYPE_ASSIGN, floatCalculationVar };
-			break;
+			std::string& literal = operandNode.value.literalValue;
+			literal = literal[0] == '-' ? literal.substr(1) : '-' + literal;
+			return operand;
 		}
+		node.value.dataType = isNumber ? operandNode.value.dataType : DATA_TYPE_INT; // -x is calculated as 0 - x
+		node.value.size = (uint32_t)Sizeof(node.value.dataType);
+		node.value.literalValue = "0";
+		tree.nodes.push_back(node);
+		return CreateBinaryExpression(tree, token, (uint32_t)tree.nodes.size() - 1, operand);
+	}
 
-		case LEXER_TOKEN_IDENTIFIER:
+	case LEXEME_AMPERSAND:
+	case LEXEME_MULTIPLY:
+	{
+		const Lexer::Token& variable = GetExpressionToken(tokens, index++);
+		if (variable.token != LEXER_TOKEN_IDENTIFIER || !simulationStackFrame.Has(variable.symbol))
+			throw std::runtime_error("Cannot get the location of variable " + std::string(variable.content) + ", it is undefined");
+
+		node.type = token.lexeme == LEXEME_AMPERSAND ? EXPRESSION_NODE_LOCATION_OF : EXPRESSION_NODE_DEREFERENCE;
+		node.value.name = variable.symbol;
+		node.value.dataType = token.lexeme == LEXEME_AMPERSAND ? DATA_TYPE_UINT64 : DATA_TYPE_VOID; // the type behind a pointer is only known at runtime
+		break;
+	}
+
+	case LEXEME_IDENTIFIER:
+		if (context.functionInfos.count(token.symbol) > 0)
 		{
-			if (functionInfos.count(tokens[i].content) <= 0)
-			{
-				if (!simulationStackFrame.Has(tokens[i].content))
-					throw std::runtime_error("Syntax error: identifier \"" + tokens[i].content + "\" is undefined");
+			index--;
+			return ParseCallExpression(tokens, index, tree);
+		}
+		if (!simulationStackFrame.Has(token.symbol))
+			throw std::runtime_error("Syntax error: identifier \"" + SymbolTable::GetName(token.symbol) + "\" is undefined");
 
-				final.operand2.dataType = simulationStackFrame.GetVariable(tokens[i].content).GetDataType();
-				final.operand2.name = tokens[i].content;
-				destination.push_back(final);
-				final = { INSTRUCTION_TYPE_ASSIGN, floatCalculationVar };
-				break;
-			}
-			// function call
-			std::string functionName = tokens[i].content;
-			i += 2; // skip over the '(' seperator
-			GetFunctionPushInstructions(tokens, i, destination);
-
-			Instruction callInst{};
-			callInst.type = INSTRUCTION_TYPE_CALL;
-			callInst.operand1 = { functionName, functionInfos[functionName].returnType };
-			destination.push_back(callInst);
-
-			final.operand2 = floatReturnVar;
-			destination.push_back(final);
-			final = { INSTRUCTION_TYPE_ASSIGN, floatCalculationVar };
-
-			if (calledFunctions.count(functionName) == 0)
-				calledFunctions.insert(functionName);
+		node.value.name = token.symbol;
+		node.value.dataType = simulationStackFrame.GetVariable(token.symbol).GetDataType();
+		node.value.size = (uint32_t)Sizeof(node.value.dataType);
+		if (index >= tokens.size() || tokens[index].lexeme != LEXEME_OPEN_SBRACKET)
 			break;
+
+		{
+			size_t closeIndex = GetIndexOfClosingSBracket(index, tokens);
+			index++;
+			uint32_t indexNode = ParseExpression(tokens.first(closeIndex), index, tree);
+			if (index != closeIndex)
+				throw std::runtime_error("Syntax error at line " + std::to_string(tokens[index].line) + ": unexpected \"" + std::string(tokens[index].content) + "\" in an index");
+			index++;
+			CheckIndexType(node.value.dataType, tree.nodes[indexNode].value.dataType, token.line);
+
+			DataType elementType = node.value.dataType == DATA_TYPE_VOID ? DATA_TYPE_VOID : GetElementDataType(node.value.dataType); // the type behind a void is only known at runtime
+			if (elementType == DATA_TYPE_INVALID)
+				throw std::runtime_error("Syntax error at line " + std::to_string(token.line) + ": cannot index " + SymbolTable::GetName(token.symbol) + ", it is not an array, a string or a map");
+
+			node.type = EXPRESSION_NODE_INDEX;
+			node.value.dataType = elementType;
+			node.value.size = (uint32_t)Sizeof(elementType);
+			node.left = indexNode;
+			node.containsCall = tree.nodes[indexNode].containsCall;
+			node.registerCount = tree.nodes[indexNode].type == EXPRESSION_NODE_VALUE ? 1 : tree.nodes[indexNode].registerCount + 1;
 		}
-		}
+		break;
+
+	default:
+		throw std::runtime_error("Syntax error at line " + std::to_string(token.line) + ": unexpected \"" + std::string(token.content) + "\" in an expression");
 	}
-	if (tokens.size() == 1)
+	tree.nodes.push_back(node);
+	return (uint32_t)tree.nodes.size() - 1;
+}
+
+uint32_t Parser::ParseCallExpression(TokenSpan tokens, size_t& index, ExpressionTree& tree)
+{
+	const Lexer::Token& functionToken = tokens[index];
+	if (GetExpressionToken(tokens, index + 1).lexeme != LEXEME_OPEN_PARENTHESIS)
+		throw std::runtime_error("Syntax error at line " + std::to_string(functionToken.line) + ": expected a '(' after function " + std::string(functionToken.content));
+	index += 2; // skip over the '(' seperator
+
+	std::vector<uint32_t> arguments; // the arguments of a call are stored next to each other, but nested calls add their own arguments while these are parsed
+	while (GetExpressionToken(tokens, index).lexeme != LEXEME_CLOSE_PARENTHESIS)
 	{
-		destination.back().type = INSTRUCTION_TYPE_ASSIGN;
-		destination.back().operand1 = varToWriteTo;
-		return;
+		arguments.push_back(ParseExpression(tokens, index, tree));
+		if (GetExpressionToken(tokens, index).lexeme == LEXEME_COMMA)
+			index++;
+		else if (tokens[index].lexeme != LEXEME_CLOSE_PARENTHESIS)
+			throw std::runtime_error("Syntax error at line " + std::to_string(tokens[index].line) + ": expected a ',' or ')' after an argument of " + std::string(functionToken.content));
 	}
-
-	Instruction assignInst{};
-	assignInst.type = INSTRUCTION_TYPE_ASSIGN;
-	assignInst.operand1 = varToWriteTo;
-	assignInst.operand2 = floatCalculationVar;
-	if (!IsInstructionSelfAssigning(assignInst))
-		destination.push_back(assignInst);
-	return;
+	index++;
+
+	ExpressionNode node{};
+	node.type = EXPRESSION_NODE_CALL;
+	node.value = { functionToken.symbol, context.functionInfos.at(functionToken.symbol).returnType }; // functionInfos is shared between threads, so it must not be modified here
+	node.left = (uint32_t)tree.arguments.size();
+	node.right = (uint32_t)arguments.size();
+	node.containsCall = true;
+	node.line = functionToken.line;
+	for (uint32_t argument : arguments)
+		node.registerCount = std::max(node.registerCount, tree.nodes[argument].registerCount + (uint32_t)tree.nodes[argument].containsCall);
+	tree.arguments.insert(tree.arguments.end(), arguments.begin(), arguments.end());
+	tree.nodes.push_back(node);
+	return (uint32_t)tree.nodes.size() - 1;
 }
 
-void Parser::ProcessDereferenceOperator(const std::vector<Lexer::Token>& tokens, size_t& i, Instruction& instruction)
+uint32_t Parser::CreateBinaryExpression(ExpressionTree& tree, const Lexer::Token& op, uint32_t left, uint32_t right)
 {
-	if (!simulationStackFrame.Has(tokens[i + 1].content))
-		throw std::runtime_error("Cannot get the location of variable " + tokens[i + 1].content + ", it is undefined");
+	const ExpressionNode& leftNode = tree.nodes[left];
+	const ExpressionNode& rightNode = tree.nodes[right];
+	CheckOperationIntegrity(op.lexeme, leftNode.value, rightNode.value, op.line);
+
+	ExpressionNode node{};
+	node.type = EXPRESSION_NODE_BINARY;
+	node.operation = GetInstructionTypeFromLexemeOperator(op.lexeme);
+	node.containsCall = leftNode.containsCall || rightNode.containsCall;
+	node.line = op.line;
+
+	// the left side is calculated in the destination and the right side is applied to it, so it is cheaper if the more complex side is on the left
+	// this can only be done if swapping the sides doesnt change the result (strings are not commutative and the type of the result is the type of the left side)
+	bool rightIsMoreComplex = rightNode.type != EXPRESSION_NODE_VALUE && (leftNode.type == EXPRESSION_NODE_VALUE || rightNode.registerCount > leftNode.registerCount);
+	if (IsInstructionCommutative(node.operation) && rightIsMoreComplex && leftNode.value.dataType == rightNode.value.dataType && !DataTypeIsString(leftNode.value.dataType))
+		std::swap(left, right);
+
+	node.left = left;
+	node.right = right;
+	node.value.dataType = tree.nodes[left].value.dataType != DATA_TYPE_VOID ? tree.nodes[left].value.dataType : tree.nodes[right].value.dataType;
+	node.value.size = (uint32_t)Sizeof(node.value.dataType);
+
+	uint32_t leftCount = tree.nodes[left].registerCount, rightCount = tree.nodes[right].registerCount;
+	node.registerCount = tree.nodes[right].type == EXPRESSION_NODE_VALUE || tree.nodes[right].type == EXPRESSION_NODE_CALL ? std::max(leftCount, rightCount) : std::max(leftCount, rightCount + 1);
+	tree.nodes.push_back(node);
+	return (uint32_t)tree.nodes.size() - 1;
+}
 
-	instruction.type = INSTRUCTION_TYPE_DEREFERENCE;
-	instruction.operand2 = instruction.operand1;
-	instruction.operand1.name = tokens[i + 1].content;
-	i++;
+VariableInfo Parser::GetExpressionOperand(const ExpressionTree& tree, uint32_t node, size_t firstFreeRegister, std::vector<Instruction>& ret)
+{
+	switch (tree.nodes[node].type)
+	{
+	case EXPRESSION_NODE_VALUE: // values can be used as an operand directly
+		return tree.nodes[node].value;
+	case EXPRESSION_NODE_CALL:
+		LowerCallExpression(tree, node, firstFreeRegister, ret);
+		return floatReturnVar;
+	}
+	VariableInfo reg = GetCalculationRegisterChecked(firstFreeRegister, tree.nodes[node].line);
+	LowerExpression(tree, node, reg, firstFreeRegister + 1, ret);
+	return reg;
 }
 
-void Parser::ProcessLocationOfOperator(const std::vector<Lexer::Token>& tokens, size_t& i, Instruction& instruction)
+void Parser::LowerExpression(const ExpressionTree& tree, uint32_t node, const VariableInfo& destination, size_t firstFreeRegister, std::vector<Instruction>& ret)
 {
-	if (!simulationStackFrame.Has(tokens[i + 1].content))
-		throw std::runtime_error("Cannot get the location of variable " + tokens[i + 1].content + ", it is undefined");
+	const ExpressionNode& current = tree.nodes[node];
+	switch (current.type)
+	{
+	case EXPRESSION_NODE_VALUE:
+	{
+		Instruction assignInst{ INSTRUCTION_TYPE_ASSIGN, destination, current.value };
+		if (!IsInstructionSelfAssigning(assignInst))
+			ret.push_back(assignInst);
+		break;
+	}
+	case EXPRESSION_NODE_CALL:
+		LowerCallExpression(tree, node, firstFreeRegister, ret);
+		ret.push_back({ INSTRUCTION_TYPE_ASSIGN, destination, floatReturnVar });
+		break;
 
-	instruction.type = INSTRUCTION_TYPE_ASSIGN_LOCATION;
-	instruction.operand2.name = tokens[i + 1].content;
-	i++;
+	case EXPRESSION_NODE_LOCATION_OF:
+		ret.push_back({ INSTRUCTION_TYPE_ASSIGN_LOCATION, destination, current.value });
+		break;
+	case EXPRESSION_NODE_DEREFERENCE: // with deference the first operand is the pointer, the second is the variable to copy to
+		ret.push_back({ INSTRUCTION_TYPE_DEREFERENCE, current.value, destination });
+		break;
+
+	case EXPRESSION_NODE_INDEX: // the array is copied into the destination (which only copies a reference to its elements) and then replaced by the element
+	{
+		VariableInfo index = GetExpressionOperand(tree, current.left, firstFreeRegister, ret);
+		VariableInfo array = { current.value.name, simulationStackFrame.GetVariable(current.value.name).GetDataType() };
+		ret.push_back({ INSTRUCTION_TYPE_ASSIGN, destination, array });
+		ret.push_back({ INSTRUCTION_TYPE_INDEX, destination, index });
+		break;
+	}
+
+	case EXPRESSION_NODE_BINARY:
+	{
+		LowerExpression(tree, current.left, destination, firstFreeRegister, ret);
+		VariableInfo rightOperand = GetExpressionOperand(tree, current.right, firstFreeRegister, ret);
+		ret.push_back({ current.operation, destination, rightOperand });
+		break;
+	}
+	}
 }
 
-VariableInfo Parser::GetAssignVariableInfo(std::vector<Lexer::Token>& lvalue)
+void Parser::LowerCallExpression(const ExpressionTree& tree, uint32_t node, size_t firstFreeRegister, std::vector<Instruction>& ret)
 {
-	return { lvalue.back().content, simulationStackFrame[lvalue.back().content].GetDataType() };
+	const ExpressionNode& call = tree.nodes[node];
+	const uint32_t* arguments = tree.arguments.data() + call.left;
+
+	// a call pushes its own parameters and overwrites the return value, so every argument with a call in it is calculated before anything is pushed
+	// only the last one can stay in the return value, the other ones are kept in registers
+	size_t lastCallArgument = call.right, reg = firstFreeRegister;
+	for (size_t i = 0; i < call.right; i++)
+		if (tree.nodes[arguments[i]].containsCall)
+			lastCallArgument = i;
+
+	for (size_t i = 0; i < call.right; i++)
+	{
+		if (!tree.nodes[arguments[i]].containsCall)
+			continue;
+		if (i == lastCallArgument && tree.nodes[arguments[i]].type == EXPRESSION_NODE_CALL)
+			LowerCallExpression(tree, arguments[i], reg, ret);
+		else
+		{
+			LowerExpression(tree, arguments[i], GetCalculationRegisterChecked(reg, call.line), reg + 1, ret);
+			reg++;
+		}
+	}
+
+	size_t callRegister = firstFreeRegister;
+	for (size_t i = 0; i < call.right; i++)
+	{
+		VariableInfo argument{};
+		if (!tree.nodes[arguments[i]].containsCall)
+			argument = GetExpressionOperand(tree, arguments[i], reg, ret);
+		else if (i == lastCallArgument && tree.nodes[arguments[i]].type == EXPRESSION_NODE_CALL)
+			argument = floatReturnVar;
+		else
+			argument = GetCalculationRegister(callRegister++);
+		ret.push_back({ INSTRUCTION_TYPE_PUSH, bufferParametersVar, argument });
+	}
+	ret.push_back({ INSTRUCTION_TYPE_CALL, call.value });
 }
 
-void Parser::ParseTokens(FunctionBody& tokens, std::vector<Instruction>& ret, size_t& scopesTraversed)
+void Parser::GetInstructionsFromRValue(TokenSpan tokens, size_t& index, std::vector<Instruction>& destination, const VariableInfo& varToWriteTo)
 {
-	for (; scopesTraversed < tokens.size(); scopesTraversed++)
+	ExpressionTree tree;
+	uint32_t root = ParseExpression(tokens, index, tree);
+	CheckOperationIntegrity(LEXEME_EQUALS, varToWriteTo, tree.nodes[root].value, tree.nodes[root].line);
+
+	// the expression can be calculated in the variable itself if that doesnt overwrite a value that is still needed
+	// internal variables (like the return value) are also changed by calls, so they only get the final result
+	bool canCalculateInPlace = !ExpressionReadsVariableLate(tree, root, varToWriteTo.name) && (!IsInternalSymbol(varToWriteTo.name) || !tree.nodes[root].containsCall);
+	if (canCalculateInPlace)
 	{
-		ParseScope(tokens, ret, scopesTraversed);
+		LowerExpression(tree, root, varToWriteTo, 0, destination);
+		return;
 	}
-	for (size_t i = 0; i < ret.size(); i++) // lazily check all instructions (not the fastest)
-		CheckInstructionIntegrity(ret[i], i);
+	Instruction assignInst{ INSTRUCTION_TYPE_ASSIGN, varToWriteTo, GetExpressionOperand(tree, root, 0, destination) };
+	if (!IsInstructionSelfAssigning(assignInst))
+		destination.push_back(assignInst);
+}
+
+VariableInfo Parser::GetAssignVariableInfo(TokenSpan lvalue)
+{
+	return { lvalue.back().symbol, simulationStackFrame[lvalue.back().symbol].GetDataType() };
 }
 
-void Parser::ParseScope(FunctionBody& tokens, std::vector<Instruction>& ret, size_t& scopesTraversed)
+void Parser::ParseScope(TokenSpan tokens, std::vector<Instruction>& ret)
 {
-	size_t scopeIndex = scopesTraversed;
-	for (size_t i = 0; i < tokens[scopeIndex].size(); i++)
+	for (size_t i = 0; i < tokens.size(); i++)
 	{
-		switch (tokens[scopeIndex][i].token)
+		switch (tokens[i].token)
 		{
 		case LEXER_TOKEN_DATATYPE:
-			i = ParseScopeDeclaration(tokens[scopeIndex], ret, i);
+			i = ParseScopeDeclaration(tokens, ret, i);
 			break;
 
 		case LEXER_TOKEN_OPERATOR: // this covers more than just the equals operators so not the best solution
-			i = ParseScopeOperator(tokens[scopeIndex], ret, i);
+			i = ParseScopeOperator(tokens, ret, i);
 			break;
 		case LEXER_TOKEN_KEYWORD:
-		{
-			ProcessKeyword(tokens, scopeIndex, scopesTraversed, i, ret);
+			ProcessKeyword(tokens, i, ret);
 			break;
-		}
 		case LEXER_TOKEN_IDENTIFIER:
-			i = ParseScopeIdentifier(tokens[scopeIndex], ret, i);
+			i = ParseScopeIdentifier(tokens, ret, i);
+			break;
+		case LEXER_TOKEN_SEPERATOR:
+			if (tokens[i].lexeme == LEXEME_OPEN_CBRACKET) // a scope without a statement in front of it
+				ParseNestedScope(tokens, i, ret);
 			break;
 		}
 	}
-	if (scopeIndex == 0 && ret.back().type != INSTRUCTION_TYPE_RETURN)
-		ret.push_back({ INSTRUCTION_TYPE_RETURN });
 }
 
-void Parser::ProcessKeyword(std::vector<std::vector<Lexer::Token>>& tokens, size_t scopeIndex, size_t& scopesTraversed, size_t& i, std::vector<Instruction>& ret)
+inline TokenSpan GetTokensInsideCBrackets(TokenSpan tokens, size_t& index) // index is left on the closing cbracket
+{
+	size_t beginIndex = index;
+	for (; beginIndex < tokens.size(); beginIndex++)
+		if (tokens[beginIndex].lexeme == LEXEME_OPEN_CBRACKET)
+			break;
+	if (beginIndex >= tokens.size())
+		throw std::runtime_error("Syntax error at line " + std::to_string(tokens[index].line) + ": expected a '{'");
+
+	index = GetIndexOfClosingCBracket(beginIndex, tokens);
+	return tokens.subspan(beginIndex + 1, index - beginIndex - 1);
+}
+
+void Parser::ParseNestedScope(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret)
 {
-	switch (tokens[scopeIndex][i].lexeme)
+	Instruction pushScopeInst{};
+	pushScopeInst.type = INSTRUCTION_TYPE_PUSH_SCOPE;
+	ret.push_back(pushScopeInst);
+	simulationStackFrame.IncrementScope();
+
+	ParseScope(GetTokensInsideCBrackets(tokens, i), ret);
+
+	Instruction popScopeInst{};
+	popScopeInst.type = INSTRUCTION_TYPE_POP_SCOPE;
+	ret.push_back(popScopeInst);
+	simulationStackFrame.DecrementScope();
+}
+
+void Parser::ProcessKeyword(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret)
+{
+	switch (tokens[i].lexeme)
 	{
 	case LEXEME_IF:
-		ProcessIfStatement(tokens, scopeIndex, scopesTraversed, i, ret);
+		ProcessIfStatement(tokens, i, ret);
 		break;
 	case LEXEME_WHILE:
-		ProcessWhileStatement(tokens, scopeIndex, scopesTraversed, i, ret);
+		ProcessWhileStatement(tokens, i, ret);
 		break;
 	case LEXEME_FOR:
-		ProcessForStatement(tokens, scopeIndex, scopesTraversed, i, ret);
+		ProcessForStatement(tokens, i, ret);
+		break;
+	case LEXEME_PARALLEL:
+		ProcessParallelForStatement(tokens, i, ret);
 		break;
 	case LEXEME_RETURN:
-		ProcessReturnStatement(tokens[scopeIndex], i, ret);
+		ProcessReturnStatement(tokens, i, ret);
+		break;
+	case LEXEME_YIELD:
+		ProcessYieldStatement(tokens, i, ret);
 		break;
 	}
 }
 
-size_t Parser::ParseScopeIdentifier(const std::vector<Lexer::Token>& tokens, std::vector<Instruction>& ret, size_t offset)
+size_t Parser::ParseScopeIdentifier(TokenSpan tokens, std::vector<Instruction>& ret, size_t offset)
 {
-	if (functionInfos.count(tokens[offset].content) <= 0)
+	if (offset + 1 < tokens.size() && tokens[offset + 1].lexeme == LEXEME_OPEN_SBRACKET)
+		return ParseIndexedAssignment(tokens, ret, offset);
+	if (context.functionInfos.count(tokens[offset].symbol) <= 0)
 		return offset;
 
-	std::string functionName = tokens[offset].content;
-	offset += 2;
-	GetFunctionPushInstructions(tokens, offset, ret);
+	ExpressionTree tree;
+	uint32_t call = ParseCallExpression(tokens, offset, tree);
+	LowerCallExpression(tree, call, 0, ret);
+	return offset - 1; // the closing parenthesis
+}
 
-	Instruction callInst{};
-	callInst.type = INSTRUCTION_TYPE_CALL;
-	callInst.operand1 = { functionName, functionInfos[functionName].returnType };
-	ret.push_back(callInst);
+size_t Parser::ParseIndexedAssignment(TokenSpan tokens, std::vector<Instruction>& ret, size_t offset)
+{
+	const Lexer::Token& arrayToken = tokens[offset];
+	if (!simulationStackFrame.Has(arrayToken.symbol))
+		throw std::runtime_error("Syntax error: identifier \"" + SymbolTable::GetName(arrayToken.symbol) + "\" is undefined");
+	VariableInfo array = { arrayToken.symbol, simulationStackFrame.GetVariable(arrayToken.symbol).GetDataType() };
+	if (!DataTypeIsArray(array.dataType) && array.dataType != DATA_TYPE_MAP)
+		throw std::runtime_error("Syntax error at line " + std::to_string(arrayToken.line) + ": cannot store to an element of " + SymbolTable::GetName(array.name) + ", it is not an array or a map");
+	if (IsSharedMap(array.name)) // storing can grow the map while another iteration reads it, the elements of an array stay where they are
+		throw std::runtime_error("Syntax error at line " + std::to_string(arrayToken.line) + ": cannot store to the map " + SymbolTable::GetName(array.name) + " inside a parallel for, it is shared by all iterations");
+	VariableInfo element = { SYMBOL_NONE, GetElementDataType(array.dataType) };
+	element.size = (uint32_t)Sizeof(element.dataType);
+
+	// the index is calculated first and stays in the first register, so that the value can contain calls
+	size_t closeIndex = GetIndexOfClosingSBracket(offset + 1, tokens), index = offset + 2;
+	ExpressionTree indexTree;
+	uint32_t indexRoot = ParseExpression(tokens.first(closeIndex), index, indexTree);
+	if (index != closeIndex)
+		throw std::runtime_error("Syntax error at line " + std::to_string(tokens[index].line) + ": unexpected \"" + std::string(tokens[index].content) + "\" in an index");
+	CheckIndexType(array.dataType, indexTree.nodes[indexRoot].value.dataType, arrayToken.line);
+
+	VariableInfo indexOperand = indexTree.nodes[indexRoot].value;
+	if (indexTree.nodes[indexRoot].type != EXPRESSION_NODE_VALUE)
+	{
+		indexOperand = GetCalculationRegisterChecked(0, arrayToken.line);
+		LowerExpression(indexTree, indexRoot, indexOperand, 1, ret);
+	}
 
-	if (calledFunctions.count(functionName) == 0)
-		calledFunctions.insert(functionName);
-	return offset;
+	size_t opIndex = closeIndex + 1;
+	if (opIndex >= tokens.size())
+		throw std::runtime_error("Syntax error at line " + std::to_string(arrayToken.line) + ": expected an assignment after the index");
+	Lexer::Token op = tokens[opIndex];
+	bool isSpecialOperator = op.lexeme == LEXEME_PLUSPLUS || op.lexeme == LEXEME_MINUSMINUS;
+	if (isSpecialOperator) // "array[i]++" is parsed as "array[i] += 1"
+		op = GetEqualsOperatorForSpecialOperator(op);
+	if (op.token != LEXER_TOKEN_OPERATOR || op.content.back() != '=')
+		throw std::runtime_error("Syntax error at line " + std::to_string(op.line) + ": expected an assignment instead of \"" + std::string(op.content) + "\"");
+
+	VariableInfo value{};
+	size_t endIndex = opIndex + 1;
+	if (op.lexeme == LEXEME_EQUALS)
+	{
+		ExpressionTree tree;
+		uint32_t root = ParseExpression(tokens, endIndex, tree);
+		CheckOperationIntegrity(LEXEME_EQUALS, element, tree.nodes[root].value, op.line);
+		value = GetExpressionOperand(tree, root, 1, ret);
+	}
+	else // the element is loaded into a register, changed there and stored again
+	{
+		value = GetCalculationRegisterChecked(1, op.line);
+		value.dataType = element.dataType;
+		ret.push_back({ INSTRUCTION_TYPE_ASSIGN, value, array });
+		ret.push_back({ INSTRUCTION_TYPE_INDEX, value, indexOperand });
+		if (isSpecialOperator)
+		{
+			GetInstructionsForLexemeEqualsOperator(op, value, { SYMBOL_NONE, DATA_TYPE_INT, sizeof(int), "1" }, DATA_TYPE_INT, ret);
+			endIndex = opIndex;
+		}
+		else
+		{
+			ExpressionTree tree;
+			uint32_t root = ParseExpression(tokens, endIndex, tree);
+			VariableInfo operand = GetExpressionOperand(tree, root, 2, ret);
+			GetInstructionsForLexemeEqualsOperator(op, value, operand, tree.nodes[root].value.dataType, ret);
+		}
+	}
+	ret.push_back({ INSTRUCTION_TYPE_ASSIGN, arrayIndexVar, indexOperand });
+	ret.push_back({ INSTRUCTION_TYPE_STORE_INDEX, array, value });
+
+	if (!isSpecialOperator && endIndex < tokens.size() && tokens[endIndex].lexeme != LEXEME_ENDLINE && tokens[endIndex].lexeme != LEXEME_CLOSE_PARENTHESIS)
+		throw std::runtime_error("Syntax error at line " + std::to_string(tokens[endIndex].line) + ": expected a ';' instead of \"" + std::string(tokens[endIndex].content) + "\"");
+	return endIndex;
 }
 
-size_t Parser::ParseScopeOperator(std::vector<Lexer::Token>& tokens, std::vector<Instruction>& ret, size_t offset)
+size_t Parser::ParseScopeOperator(TokenSpan tokens, std::vector<Instruction>& ret, size_t offset)
 {
-	if (tokens[offset].lexeme == LEXEME_PLUSPLUS || tokens[offset].lexeme == LEXEME_MINUSMINUS)
-		ReplaceTokensForSpecialOperator(offset, tokens);
+	Lexer::Token op = tokens[offset];
+	bool isSpecialOperator = op.lexeme == LEXEME_PLUSPLUS || op.lexeme == LEXEME_MINUSMINUS;
+	if (isSpecialOperator) // "var++" is parsed as "var += 1"
+		op = GetEqualsOperatorForSpecialOperator(op);
 	
-	if (tokens[offset].content.back() != '=')
+	if (op.content.back() != '=')
 		return offset;
 
-	size_t endIndex = GetNextInstanceOfLexeme(LEXEME_ENDLINE, offset, tokens);
-	size_t otherEndIndex = GetNextInstanceOfLexeme(LEXEME_CLOSE_PARENTHESIS, offset, tokens); // this applies to conditional stuff like if's and whiles
-	if (endIndex == 0 || (otherEndIndex != 0 && otherEndIndex < endIndex))
-		endIndex = otherEndIndex;
-
-	std::vector<Lexer::Token> lvalue = { tokens.begin(), tokens.begin() + offset };
-	std::vector<Lexer::Token> rvalue = { tokens.begin() + offset + 1, tokens.begin() + endIndex };
+	VariableInfo assignVar = GetAssignVariableInfo(tokens.first(offset));
+	if (IsSharedVariable(assignVar.name)) // every block of iterations works on its own copy of the variables from before the loop, so the assignment would be lost
+		throw std::runtime_error("Syntax error at line " + std::to_string(op.line) + ": cannot assign to " + SymbolTable::GetName(assignVar.name) + " inside a parallel for, it was declared before the loop, store the result in an array instead");
+	if (isSpecialOperator)
+	{
+		GetInstructionsForLexemeEqualsOperator(op, assignVar, { SYMBOL_NONE, DATA_TYPE_INT, sizeof(int), "1" }, DATA_TYPE_INT, ret);
+		return offset;
+	}
 
-	VariableInfo assignVar = GetAssignVariableInfo(lvalue);
-	GetInstructionsFromRValueRecursive(rvalue, ret, floatCalculationVar);
-	GetInstructionsForLexemeEqualsOperator(tokens[offset], assignVar, ret);
+	size_t endIndex = offset + 1;
+	if (op.lexeme == LEXEME_EQUALS)
+		GetInstructionsFromRValue(tokens, endIndex, ret, assignVar);
+	else
+	{
+		ExpressionTree tree;
+		uint32_t root = ParseExpression(tokens, endIndex, tree);
+		VariableInfo value = GetExpressionOperand(tree, root, 0, ret);
+		GetInstructionsForLexemeEqualsOperator(op, assignVar, value, tree.nodes[root].value.dataType, ret);
+	}
+	if (endIndex < tokens.size() && tokens[endIndex].lexeme != LEXEME_ENDLINE && tokens[endIndex].lexeme != LEXEME_CLOSE_PARENTHESIS) // a closing parenthesis ends the last part of a for statement
+		throw std::runtime_error("Syntax error at line " + std::to_string(tokens[endIndex].line) + ": expected a ';' instead of \"" + std::string(tokens[endIndex].content) + "\"");
 	return endIndex;
 }
 
-size_t Parser::ParseScopeDeclaration(const std::vector<Lexer::Token>& tokens, std::vector<Instruction>& ret, size_t offset)
+size_t Parser::ParseScopeDeclaration(TokenSpan tokens, std::vector<Instruction>& ret, size_t offset)
 {
 	VariableInfo declVar{};
 	declVar.dataType = (DataType)tokens[offset].lexeme;
-	declVar.name = tokens[offset + 1].content;
+	if (offset + 2 < tokens.size() && tokens[offset + 1].lexeme == LEXEME_OPEN_SBRACKET && tokens[offset + 2].lexeme == LEXEME_CLOSE_SBRACKET) // "int[] var" declares an array, the rest of the declaration is parsed as if the [] is not there
+	{
+		declVar.dataType = GetArrayDataType(declVar.dataType);
+		if (declVar.dataType == DATA_TYPE_INVALID)
+			throw std::runtime_error("Syntax error at line " + std::to_string(tokens[offset].line) + ": there are no arrays of type " + std::string(tokens[offset].content) + ", only int[] and float[]");
+		offset += 2;
+	}
+	declVar.name = tokens[offset + 1].symbol;
 	declVar.size = (uint32_t)Sizeof(declVar.dataType);
 
 	Instruction declareInst{};
@@ -426,44 +825,33 @@ size_t Parser::ParseScopeDeclaration(const std::vector<Lexer::Token>& tokens, st
 	if (tokens[offset + 2].lexeme == LEXEME_ENDLINE) // declaring without a value has a ; at the third token
 		return offset + 2;
 
-	size_t indexOfEndLine = GetNextInstanceOfLexeme(LEXEME_ENDLINE, offset, tokens);
-	std::vector<Lexer::Token> rvalueTokens = { tokens.begin() + offset + 3, tokens.begin() + indexOfEndLine };
-	GetInstructionsFromRValueRecursive(rvalueTokens, ret, declVar);
+	size_t indexOfEndLine = offset + 3;
+	GetInstructionsFromRValue(tokens, indexOfEndLine, ret, declVar);
+	if (indexOfEndLine >= tokens.size() || tokens[indexOfEndLine].lexeme != LEXEME_ENDLINE)
+		throw std::runtime_error("Syntax error at line " + std::to_string(tokens[offset].line) + ": expected a ';' after the declaration of " + SymbolTable::GetName(declVar.name));
 	return indexOfEndLine;
 }
 
-void Parser::ReplaceTokensForSpecialOperator(size_t index, std::vector<Lexer::Token>& tokens)
+Lexer::Token Parser::GetEqualsOperatorForSpecialOperator(const Lexer::Token& op)
 {
-	switch (tokens[index].lexeme)
+	Lexer::Token ret = op;
+	switch (op.lexeme)
 	{
 	case LEXEME_PLUSPLUS:
-		tokens[index].lexeme = LEXEME_PLUSEQUALS;
-		tokens[index].content = "+=";
+		ret.lexeme = LEXEME_PLUSEQUALS;
+		ret.content = "+=";
 		break;
 	case LEXEME_MINUSMINUS:
-		tokens[index].lexeme = LEXEME_MINUSEQUALS;
-		tokens[index].content = "-=";
+		ret.lexeme = LEXEME_MINUSEQUALS;
+		ret.content = "-=";
 		break;
 	}
-	Lexer::Token newToken{};
-	newToken.token = LEXER_TOKEN_LITERAL;
-	newToken.lexeme = LEXEME_LITERAL_INT;
-	newToken.line = tokens[index].line;
-	newToken.content = "1";
-
-	tokens.insert(tokens.begin() + index + 1, newToken);
-	return;
+	return ret;
 }
 
-void Parser::GetInstructionsForLexemeEqualsOperator(const Lexer::Token& op, const VariableInfo& info, std::vector<Instruction>& instructions)
+void Parser::GetInstructionsForLexemeEqualsOperator(const Lexer::Token& op, const VariableInfo& info, const VariableInfo& varToReadFrom, DataType readType, std::vector<Instruction>& instructions)
 {
-	VariableInfo varToReadFrom = floatCalculationVar;
-	if (instructions.back().type == INSTRUCTION_TYPE_ASSIGN && instructions.back().operand1.name == varToReadFrom.name) // merge instructions that would otherwise just pass values along
-	{
-		varToReadFrom = instructions.back().operand2;
-		instructions.pop_back();
-	}
-	CheckOperationIntegrity(op.lexeme, info, varToReadFrom, op.line);
+	CheckOperationIntegrity(op.lexeme, info, { SYMBOL_NONE, readType }, op.line);
 
 	Instruction inst{};
 	inst.operand1 = info;
@@ -490,7 +878,7 @@ void Parser::GetInstructionsForLexemeEqualsOperator(const Lexer::Token& op, cons
 	instructions.push_back(inst);
 }
 
-void Parser::ProcessReturnStatement(std::vector<Lexer::Token>& tokens, size_t& i, std::vector<Instruction>& ret)
+void Parser::ProcessReturnStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret)
 {
 	Instruction returnInst{};
 	returnInst.type = INSTRUCTION_TYPE_RETURN;
@@ -500,251 +888,278 @@ void Parser::ProcessReturnStatement(std::vector<Lexer::Token>& tokens, size_t& i
 		return;
 	}
 
-	std::vector<Lexer::Token> returnValueTokens = { tokens.begin() + i + 1, tokens.begin() + GetNextInstanceOfLexeme(LEXEME_ENDLINE, i, tokens) };
-	GetInstructionsFromRValueRecursive(returnValueTokens, ret, floatReturnVar);
+	i++;
+	GetInstructionsFromRValue(tokens, i, ret, floatReturnVar);
 	ret.push_back(returnInst);
 }
 
-void Parser::ProcessIfStatement(std::vector<std::vector<Lexer::Token>>& tokens, size_t scopeIndex, size_t& scopesTraversed, size_t& i, std::vector<Instruction>& ret)
+void Parser::ProcessYieldStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret) // the value is handed over in %frv, just like a returned value
 {
-	GetConditionInstructions(tokens[scopeIndex], i + 2, ret);
+	if (tokens[i + 1].lexeme == LEXEME_ENDLINE)
+		throw std::runtime_error("Syntax error at line " + std::to_string(tokens[i].line) + ": yield needs a value");
+
+	i++;
+	GetInstructionsFromRValue(tokens, i, ret, floatReturnVar);
+	ret.push_back({ INSTRUCTION_TYPE_YIELD });
+}
+
+inline TokenSpan GetConditionTokens(TokenSpan tokens, size_t index) // index is the if or while keyword, the condition is everything inside of the parentheses after it
+{
+	int parenReferenceCount = 0;
+	for (size_t conditionEnd = index + 1; conditionEnd < tokens.size(); conditionEnd++)
+	{
+		if (tokens[conditionEnd].lexeme == LEXEME_OPEN_PARENTHESIS)
+			parenReferenceCount++;
+		else if (tokens[conditionEnd].lexeme == LEXEME_CLOSE_PARENTHESIS && --parenReferenceCount == 0)
+			return tokens.subspan(index + 2, conditionEnd - index - 2);
+	}
+	throw std::runtime_error("Syntax error at line " + std::to_string(tokens[index].line) + ": expected a condition between parentheses");
+}
+
+void Parser::ProcessIfStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret)
+{
+	GetConditionInstructions(GetConditionTokens(tokens, i), ret);
 
 	Instruction jumpInst{};
 	jumpInst.type = INSTRUCTION_TYPE_JUMP;
 	ret.push_back(jumpInst);
 	size_t jumpInstIndex = ret.size() - 1;
 
-	Instruction pushScopeInst{};
-	pushScopeInst.type = INSTRUCTION_TYPE_PUSH_SCOPE;
-	ret.push_back(pushScopeInst);
-
-	simulationStackFrame.IncrementScope();
-
-	scopesTraversed++;
-	ParseTokens(tokens, ret, scopesTraversed);
-	scopesTraversed--;
-
-	Instruction popScopeInst{};
-	popScopeInst.type = INSTRUCTION_TYPE_POP_SCOPE;
-	ret.push_back(popScopeInst);
-
-	simulationStackFrame.DecrementScope();
+	ParseNestedScope(tokens, i, ret);
 
-	ret[jumpInstIndex].operand1 = { std::to_string(ret.size() - jumpInstIndex), DATA_TYPE_INT };
-	for (; i < tokens[scopeIndex].size(); i++)
-		if (tokens[scopeIndex][i].lexeme == LEXEME_CLOSE_PARENTHESIS)
-			break;
-	return;
+	ret[jumpInstIndex].operand1 = { SYMBOL_NONE, DATA_TYPE_INT, sizeof(int), std::to_string(ret.size() - jumpInstIndex) };
 }
 
-void Parser::ProcessWhileStatement(std::vector<std::vector<Lexer::Token>>& tokens, size_t scopeIndex, size_t& scopesTraversed, size_t& i, std::vector<Instruction>& ret)
+void Parser::ProcessWhileStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret)
 {
 	size_t conditionIndex = ret.size();
-	GetConditionInstructions(tokens[scopeIndex], i + 2, ret);
+	GetConditionInstructions(GetConditionTokens(tokens, i), ret);
 
 	Instruction jumpInst{};
 	jumpInst.type = INSTRUCTION_TYPE_JUMP;
-	size_t jumpInstIndex = conditionIndex + 1;
+	size_t jumpInstIndex = ret.size();
 	ret.push_back(jumpInst);
 
-	Instruction pushScopeInst{};
-	pushScopeInst.type = INSTRUCTION_TYPE_PUSH_SCOPE;
-	ret.push_back(pushScopeInst);
-	simulationStackFrame.IncrementScope();
-
-	scopesTraversed++;
-	ParseTokens(tokens, ret, scopesTraversed);
-	scopesTraversed--;
-
-	Instruction popScopeInst{};
-	popScopeInst.type = INSTRUCTION_TYPE_POP_SCOPE;
-	ret.push_back(popScopeInst);
-	simulationStackFrame.DecrementScope();
+	ParseNestedScope(tokens, i, ret);
 
 	Instruction loopBackInst{};
 	loopBackInst.type = INSTRUCTION_TYPE_JUMP;
-	loopBackInst.operand1 = { std::to_string((int64_t)conditionIndex - (int64_t)ret.size()), DATA_TYPE_INT };
+	loopBackInst.operand1 = { SYMBOL_NONE, DATA_TYPE_INT, sizeof(int), std::to_string((int64_t)conditionIndex - (int64_t)ret.size()) };
 	ret.push_back(loopBackInst);
 
-	ret[jumpInstIndex].operand1 = { std::to_string(ret.size() - jumpInstIndex), DATA_TYPE_INT };
-	for (; i < tokens[scopeIndex].size(); i++)
-		if (tokens[scopeIndex][i].lexeme == LEXEME_CLOSE_PARENTHESIS)
-			break;
-	return;
+	ret[jumpInstIndex].operand1 = { SYMBOL_NONE, DATA_TYPE_INT, sizeof(int), std::to_string(ret.size() - jumpInstIndex) };
 }
 
-void Parser::ProcessForStatement(std::vector<std::vector<Lexer::Token>>& tokens, size_t scopeIndex, size_t& scopesTraversed, size_t& i, std::vector<Instruction>& ret)
+void Parser::ProcessForStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret)
 {
-	size_t endOfPart1 = GetNextInstanceOfLexeme(LEXEME_ENDLINE, i, tokens[scopeIndex]);
-	size_t endOfPart2 = GetNextInstanceOfLexeme(LEXEME_ENDLINE, endOfPart1 + 1, tokens[scopeIndex]);
-	size_t endOfPart3 = GetNextInstanceOfLexeme(LEXEME_CLOSE_PARENTHESIS, endOfPart2 + 1, tokens[scopeIndex]);
+	size_t endOfPart1 = GetNextInstanceOfLexeme(LEXEME_ENDLINE, i, tokens);
+	size_t endOfPart2 = GetNextInstanceOfLexeme(LEXEME_ENDLINE, endOfPart1 + 1, tokens);
+	size_t endOfPart3 = GetNextInstanceOfLexeme(LEXEME_CLOSE_PARENTHESIS, endOfPart2 + 1, tokens);
 
-	std::vector<Lexer::Token> part1 = { tokens[scopeIndex].begin() + i + 1, tokens[scopeIndex].begin() + endOfPart1 + 1 };
-	std::vector<Lexer::Token> part2 = { tokens[scopeIndex].begin() + endOfPart1 + 1, tokens[scopeIndex].begin() + endOfPart2 + 1 };
-	std::vector<Lexer::Token> part3 = { tokens[scopeIndex].begin() + endOfPart2 + 1, tokens[scopeIndex].begin() + endOfPart3 + 1 };
+	TokenSpan part1 = tokens.subspan(i + 2, endOfPart1 - i - 1);                   // "int i = 0;"
+	TokenSpan part2 = tokens.subspan(endOfPart1 + 1, endOfPart2 - endOfPart1 - 1); // "i < 10"
+	TokenSpan part3 = tokens.subspan(endOfPart2 + 1, endOfPart3 - endOfPart2);     // "i++)"
 
 	Instruction pushScopeInst{};
 	pushScopeInst.type = INSTRUCTION_TYPE_PUSH_SCOPE;
 	ret.push_back(pushScopeInst);
 	simulationStackFrame.IncrementScope();
 
-	size_t holder = 0;
-	FunctionBody forDecl = { part1 };
-	ParseTokens(forDecl, ret, holder);
-	ret.pop_back(); // ParseTokens adds a return instruction at the end of the return value if the scopesTraversed argument is 0, but thats not wanted here
+	ParseScope(part1, ret);
 	ret.push_back(pushScopeInst); // the for loop variable is declared in its own scope, since the code outside the for loop cant reach it but it has to stay alive in between loops
 	simulationStackFrame.IncrementScope();
-	holder = 0;
 
 	size_t conditionIndex = ret.size();
-	part2.back().lexeme = LEXEME_CLOSE_PARENTHESIS;
-	GetConditionInstructions(part2, 0, ret);
+	GetConditionInstructions(part2, ret);
 
 	Instruction jumpInst{};
 	jumpInst.type = INSTRUCTION_TYPE_JUMP;
+	size_t jumpInstIndex = ret.size();
 	ret.push_back(jumpInst);
-	size_t jumpInstIndex = conditionIndex + 1;
 
-	scopesTraversed++;
-	ParseTokens(tokens, ret, scopesTraversed);
-	scopesTraversed--;
+	i = endOfPart3;
+	ParseScope(GetTokensInsideCBrackets(tokens, i), ret);
 
 	Instruction popScopeInst{};
 	popScopeInst.type = INSTRUCTION_TYPE_POP_SCOPE;
 
-	FunctionBody endOfLoopComputations = { part3 };
-	ParseTokens(endOfLoopComputations, ret, holder);
-	ret.pop_back();
+	ParseScope(part3, ret);
 
 	Instruction loopBackInst{};
 	loopBackInst.type = INSTRUCTION_TYPE_JUMP;
-	loopBackInst.operand1 = { std::to_string((int64_t)conditionIndex - (int64_t)ret.size()), DATA_TYPE_INT };
+	loopBackInst.operand1 = { SYMBOL_NONE, DATA_TYPE_INT, sizeof(int), std::to_string((int64_t)conditionIndex - (int64_t)ret.size()) };
 	ret.push_back(loopBackInst);
 
-	ret[jumpInstIndex].operand1 = { std::to_string(ret.size() - jumpInstIndex), DATA_TYPE_INT };
+	ret[jumpInstIndex].operand1 = { SYMBOL_NONE, DATA_TYPE_INT, sizeof(int), std::to_string(ret.size() - jumpInstIndex) };
 
 	ret.push_back(popScopeInst);
 	ret.push_back(popScopeInst);
 	simulationStackFrame.DecrementScope();
 	simulationStackFrame.DecrementScope();
-
-	for (; i < tokens[scopeIndex].size(); i++)
-		if (tokens[scopeIndex][i].lexeme == LEXEME_CLOSE_PARENTHESIS)
-			break;
-	return;
 }
 
-void Parser::GetConditionInstructions(std::vector<Lexer::Token>& tokens, size_t index, std::vector<Instruction>& ret)
+void Parser::ProcessParallelForStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret)
 {
-	size_t conditionMid = GetNextInstanceOfLexicalToken(LEXER_TOKEN_OPERATOR, index, tokens);
-	size_t conditionEnd = GetNextInstanceOfLexeme(LEXEME_CLOSE_PARENTHESIS, index, tokens);
+	std::string line = std::to_string(tokens[i].line);
+	if (i + 1 >= tokens.size() || tokens[i + 1].lexeme != LEXEME_FOR)
+		throw std::runtime_error("Syntax error at line " + line + ": expected a for statement after \"parallel\"");
+	i++;
 
-	Instruction compareInst{};
-	compareInst.type = GetInstructionTypeFromLexemeOperator(tokens[conditionMid].lexeme);
-	compareInst.operand1 = leftBoolValue;
-	compareInst.operand2 = rightBoolValue;
+	size_t endOfPart1 = GetNextInstanceOfLexeme(LEXEME_ENDLINE, i, tokens);
+	size_t endOfPart2 = GetNextInstanceOfLexeme(LEXEME_ENDLINE, endOfPart1 + 1, tokens);
+	size_t endOfPart3 = GetNextInstanceOfLexeme(LEXEME_CLOSE_PARENTHESIS, endOfPart2 + 1, tokens);
 
-	std::vector<Lexer::Token> lvalue = { tokens.begin() + index, tokens.begin() + conditionMid };
-	std::vector<Lexer::Token> rvalue = { tokens.begin() + conditionMid + 1, tokens.begin() + conditionEnd };
+	TokenSpan part1 = tokens.subspan(i + 2, endOfPart1 - i - 1);                   // "int i = 0;"
+	TokenSpan part2 = tokens.subspan(endOfPart1 + 1, endOfPart2 - endOfPart1 - 1); // "i < count"
+	TokenSpan part3 = tokens.subspan(endOfPart2 + 1, endOfPart3 - endOfPart2 - 1); // "i++"
 
-	if (lvalue.size() > 1)
-		GetInstructionsFromRValueRecursive(lvalue, ret, leftBoolValue);
-	else if (lvalue[0].token == LEXER_TOKEN_LITERAL)
-	{
-		compareInst.operand1.dataType = LexemeLiteralToDataType(lvalue[0].lexeme);
-		compareInst.operand1.literalValue = lvalue[0].token;
-	}
-	else
-	{
-		compareInst.operand1.name = lvalue[0].content;
-		compareInst.operand1.dataType = simulationStackFrame[lvalue[0].content].GetDataType();
-	}
-	compareInst.operand1.size = (uint32_t)Sizeof(compareInst.operand1.dataType);
+	// the iterations are handed out to the threads in blocks, which only works if the loop counts up through a range that is known before it starts
+	if (part1.size() < 2 || part1[0].lexeme != LEXEME_DATATYPE_INT || part1[1].token != LEXER_TOKEN_IDENTIFIER)
+		throw std::runtime_error("Syntax error at line " + line + ": a parallel for has to declare an int as its loop variable");
+	VariableInfo loopVariable = { part1[1].symbol, DATA_TYPE_INT, sizeof(int) };
+	auto IsLoopVariable = [&](const Lexer::Token& token) { return token.token == LEXER_TOKEN_IDENTIFIER && token.symbol == loopVariable.name; };
+	if (part2.size() < 3 || !IsLoopVariable(part2[0]) || part2[1].lexeme != LEXEME_LESS)
+		throw std::runtime_error("Syntax error at line " + line + ": the condition of a parallel for has to be \"" + std::string(part1[1].content) + " < ...\"");
+	if (part3.size() != 2 || !IsLoopVariable(part3[0]) || part3[1].lexeme != LEXEME_PLUSPLUS)
+		throw std::runtime_error("Syntax error at line " + line + ": a parallel for has to end with \"" + std::string(part1[1].content) + "++\"");
 
-	if (rvalue.size() > 1)
-		GetInstructionsFromRValueRecursive(rvalue, ret, rightBoolValue);
-	else if (rvalue[0].token == LEXER_TOKEN_LITERAL)
-	{
-		compareInst.operand2.dataType = LexemeLiteralToDataType(rvalue[0].lexeme);
-		compareInst.operand2.literalValue = rvalue[0].token;
-	}
-	else
+	Instruction pushScopeInst{};
+	pushScopeInst.type = INSTRUCTION_TYPE_PUSH_SCOPE;
+	Instruction popScopeInst{};
+	popScopeInst.type = INSTRUCTION_TYPE_POP_SCOPE;
+
+	ret.push_back(pushScopeInst);
+	simulationStackFrame.IncrementScope();
+	ParseScope(part1, ret);
+
+	ExpressionTree tree;
+	size_t endIndex = 2;
+	uint32_t end = ParseExpression(part2, endIndex, tree);
+	if (endIndex < part2.size())
+		throw std::runtime_error("Syntax error at line " + std::to_string(part2[endIndex].line) + ": unexpected \"" + std::string(part2[endIndex].content) + "\" in a condition");
+	ret.push_back({ INSTRUCTION_TYPE_PARALLEL_FOR, loopVariable, GetExpressionOperand(tree, end, 0, ret) });
+
+	Instruction jumpInst{}; // the body is run by the parallel for itself, the thread that reaches the loop continues after it
+	jumpInst.type = INSTRUCTION_TYPE_JUMP;
+	size_t jumpInstIndex = ret.size();
+	ret.push_back(jumpInst);
+
+	i = endOfPart3;
+	TokenSpan body = GetTokensInsideCBrackets(tokens, i);
+	size_t previousSharedScopeCount = sharedScopeCount; // a nested parallel for shares the variables of the outer body as well
+	sharedScopeCount = simulationStackFrame.Size();
+	const Symbol removeKey = SymbolTable::Find("RemoveKey"), clearMap = SymbolTable::Find("ClearMap"); // SYMBOL_NONE if the script never names them
+	for (size_t j = 0; j < body.size(); j++)
 	{
-		compareInst.operand2.name = rvalue[0].content;
-		compareInst.operand2.dataType = simulationStackFrame[rvalue[0].content].GetDataType();
+		if (body[j].lexeme == LEXEME_RETURN || body[j].lexeme == LEXEME_YIELD) // the iterations run on other threads, there is no call for them to return from
+			throw std::runtime_error("Syntax error at line " + std::to_string(body[j].line) + ": cannot " + std::string(body[j].content) + " from inside a parallel for");
+		bool changesMap = body[j].token == LEXER_TOKEN_IDENTIFIER && body[j].symbol != SYMBOL_NONE && (body[j].symbol == removeKey || body[j].symbol == clearMap);
+		if (changesMap && j + 2 < body.size() && body[j + 2].token == LEXER_TOKEN_IDENTIFIER && IsSharedMap(body[j + 2].symbol)) // the variables of the body are not declared yet, so a map found here is shared
+			throw std::runtime_error("Syntax error at line " + std::to_string(body[j].line) + ": cannot change the map " + std::string(body[j + 2].content) + " inside a parallel for, it is shared by all iterations");
 	}
-	compareInst.operand2.size = (uint32_t)Sizeof(compareInst.operand2.dataType);
-		
-	ret.push_back(compareInst);
+
+	ret.push_back(pushScopeInst); // the variables declared in the body are removed after every iteration
+	simulationStackFrame.IncrementScope();
+	ParseScope(body, ret);
+	ret.push_back(popScopeInst);
+	simulationStackFrame.DecrementScope();
+	sharedScopeCount = previousSharedScopeCount;
+
+	ret[jumpInstIndex].operand1 = { SYMBOL_NONE, DATA_TYPE_INT, sizeof(int), std::to_string(ret.size() - jumpInstIndex) };
+
+	ret.push_back(popScopeInst);
+	simulationStackFrame.DecrementScope();
 }
 
-std::vector<Instruction> Parser::GetInstructionsFromScopes(std::vector<std::vector<Lexer::Token>>& tokens)
+bool Parser::IsSharedVariable(Symbol variable)
 {
-	std::vector<Instruction> ret;
-	Instruction current;
+	for (size_t i = simulationStackFrame.Size(); i > 0; i--) // the innermost declaration decides, a variable of the body may hide one from before the loop
+		if (simulationStackFrame.At(i - 1).count(variable) > 0)
+			return i - 1 < sharedScopeCount;
+	return false;
+}
 
-	size_t index = 0;
-	ParseTokens(tokens, ret, index);
-	
-	return ret;
+bool Parser::IsSharedMap(Symbol variable)
+{
+	return IsSharedVariable(variable) && simulationStackFrame.GetVariable(variable).GetDataType() == DATA_TYPE_MAP;
 }
 
-inline void GetScopesRecursive(std::vector<Lexer::Token>& tokens, int& index, FunctionBody& ret)
+void Parser::GetConditionInstructions(TokenSpan condition, std::vector<Instruction>& ret)
 {
-	ret.push_back({});
-	size_t assigningIndex = ret.size() - 1;
-	for (; index < tokens.size(); index++)
+	ExpressionTree tree;
+	size_t index = 0;
+	uint32_t left = ParseExpression(condition, index, tree);
+
+	Instruction compareInst{};
+	compareInst.type = GetInstructionTypeFromLexemeOperator(GetExpressionToken(condition, index).lexeme);
+	if (!IsInstructionComparison(compareInst.type))
+		throw std::runtime_error("Syntax error at line " + std::to_string(condition[index].line) + ": expected a comparison instead of \"" + std::string(condition[index].content) + "\"");
+	index++;
+
+	uint32_t right = ParseExpression(condition, index, tree);
+	if (index < condition.size())
+		throw std::runtime_error("Syntax error at line " + std::to_string(condition[index].line) + ": unexpected \"" + std::string(condition[index].content) + "\" in a condition");
+
+	if (tree.nodes[left].type == EXPRESSION_NODE_CALL && tree.nodes[right].containsCall) // the return value would be overwritten by the call on the right side
 	{
-		switch (tokens[index].lexeme)
-		{
-		case LEXEME_OPEN_CBRACKET:
-			index++;
-			GetScopesRecursive(tokens, index, ret);
-			break;
-		case LEXEME_CLOSE_CBRACKET:
-			return;
-		default:
-			ret[assigningIndex].push_back(tokens[index]);
-			break;
-		}
+		compareInst.operand1 = GetCalculationRegister(0);
+		LowerExpression(tree, left, compareInst.operand1, 1, ret);
 	}
+	else
+		compareInst.operand1 = GetExpressionOperand(tree, left, 0, ret);
+	compareInst.operand2 = GetExpressionOperand(tree, right, 1, ret);
+	ret.push_back(compareInst);
 }
 
-FunctionBody Parser::GetAllScopesFromBody(std::vector<Lexer::Token>& tokens)
+std::vector<Instruction> Parser::GetInstructionsFromFunctionBody(TokenSpan body)
 {
-	FunctionBody ret = {};
-	int i = 0;
-	GetScopesRecursive(tokens, i, ret);
+	std::vector<Instruction> ret;
+	ParseScope(body, ret);
+	if (ret.empty() || ret.back().type != INSTRUCTION_TYPE_RETURN)
+		ret.push_back({ INSTRUCTION_TYPE_RETURN });
 
+	for (size_t i = 0; i < ret.size(); i++) // lazily check all instructions (not the fastest)
+		CheckInstructionIntegrity(ret[i], i);
 	return ret;
 }
 
-AbstractSyntaxTree Parser::CreateAST(std::vector<Lexer::Token>& tokens)
+AbstractSyntaxTree Parser::CreateAST(ScriptContext& context, TokenSpan tokens)
 {
-	AbstractSyntaxTree ret{};
 	if (tokens.empty())
-		return ret;
-	CheckOpenCloseIntegrityPremature(tokens);
+		return {};
+	return CreateAST(context, GetAllFunctionInfos(context, tokens));
+}
+
+AbstractSyntaxTree Parser::CreateAST(ScriptContext& context, const std::vector<FunctionInfo>& infos)
+{
+	for (const FunctionInfo& info : infos) // the results are merged in declaration order, so the outcome does not depend on which thread compiled what
+	{
+		context.functionInfos[info.name] = info;
+		for (const Instruction& instruction : info.instructions)
+			if (instruction.type == INSTRUCTION_TYPE_CALL)
+				context.calledFunctions.insert(instruction.operand1.name);
+	}
 
-	std::vector<FunctionInfo> infos = GetAllFunctionInfos(tokens);
+	AbstractSyntaxTree ret{};
+	Symbol entryPoint = SymbolTable::Intern(context.behavior.entryPoint);
 	for (FunctionInfo info : infos)
 	{
-		if (Behavior::removeUnusedSymbols && info.name != Behavior::entryPoint && calledFunctions.count(info.name) == 0)
+		if (context.behavior.removeUnusedSymbols && info.name != entryPoint && context.calledFunctions.count(info.name) == 0)
 		{
-			if (Behavior::verbose)
-				std::cout << "found unused function " << info.name << ", removing...\n";
+			if (context.behavior.verbose)
+				std::cout << "found unused function " << SymbolTable::GetName(info.name) << ", removing...\n";
 			continue;
 		}
 
-		Function* fnPtr = new Function(info);
+		Function* fnPtr = new Function(context, info);
 		ret.functions.insert(fnPtr);
-		if (info.name == Behavior::entryPoint)
+		if (info.name == entryPoint)
 			ret.entryPoint = fnPtr;
 	}
 	return ret;
 }
 
-FunctionInfo Parser::GetFunctionInfoFromTokens(std::vector<Lexer::Token>& tokens)
+FunctionInfo Parser::GetFunctionInfoFromTokens(TokenSpan tokens)
 {
 	if (tokens.size() < 4)
 		throw std::runtime_error("Not enough tokens"); // functions always have more than 3 tokens
@@ -760,7 +1175,7 @@ FunctionInfo Parser::GetFunctionInfoFromTokens(std::vector<Lexer::Token>& tokens
 			recordParams = true;
 			break;
 		case LEXEME_CLOSE_PARENTHESIS:
-			if (currentVarInfo.name != "")
+			if (currentVarInfo.name != SYMBOL_NONE)
 				ret.parameters.push_back(currentVarInfo);
 			recordParams = false;
 			break;
@@ -770,6 +1185,7 @@ FunctionInfo Parser::GetFunctionInfoFromTokens(std::vector<Lexer::Token>& tokens
 		case LEXEME_DATATYPE_INT:
 		case LEXEME_DATATYPE_VOID:
 		case LEXEME_DATATYPE_STRING:
+		case LEXEME_DATATYPE_MAP:
 			if (recordParams)
 			{
 				currentVarInfo.dataType = (DataType)tokens[i].lexeme;
@@ -779,11 +1195,22 @@ FunctionInfo Parser::GetFunctionInfoFromTokens(std::vector<Lexer::Token>& tokens
 				ret.returnType = (DataType)tokens[i].lexeme;
 			break;
 
+		case LEXEME_CLOSE_SBRACKET: // the [] after a type makes it an array of that type
+		{
+			DataType& type = recordParams ? currentVarInfo.dataType : ret.returnType;
+			type = GetArrayDataType(type);
+			if (type == DATA_TYPE_INVALID)
+				throw std::runtime_error("Syntax error at line " + std::to_string(tokens[i].line) + ": there are only int[] and float[] arrays");
+			if (recordParams)
+				currentVarInfo.size = (uint32_t)Sizeof(type);
+			break;
+		}
+
 		case LEXEME_IDENTIFIER:
 			if (recordParams)
-				currentVarInfo.name = tokens[i].content;
+				currentVarInfo.name = tokens[i].symbol;
 			else
-				ret.name = tokens[i].content;
+				ret.name = tokens[i].symbol;
 			break;
 
 		case LEXEME_COMMA:
@@ -823,7 +1250,7 @@ inline bool IsOperatorBinary(Lexeme op)
 	return false;
 }
 
-void Parser::CheckOpenCloseIntegrityPremature(const std::vector<Lexer::Token>& tokens)
+void Parser::CheckOpenCloseIntegrityPremature(TokenSpan tokens)
 {
 	size_t closeParenCount = 0, openParenCount = 0;
 	size_t closeCBracketCount = 0, openCBracketCount = 0;
@@ -871,7 +1298,15 @@ void Parser::CheckOperationIntegrity(const Lexeme op, const VariableInfo& lvalue
 	if (lvalue.dataType == LEXEME_DATATYPE_VOID || rvalue.dataType == DATA_TYPE_VOID || op == LEXEME_INVALID)
 		return; // voids cannot be checked
 
-	if (Behavior::disableImplicitConversion && (lvalue.dataType != rvalue.dataType))
+	bool isContainer = DataTypeIsArray(lvalue.dataType) || DataTypeIsArray(rvalue.dataType) || lvalue.dataType == DATA_TYPE_MAP || rvalue.dataType == DATA_TYPE_MAP;
+	if (isContainer) // an array or map can only be assigned one of the same type, everything else is done with its elements
+	{
+		if (op == LEXEME_EQUALS && lvalue.dataType == rvalue.dataType)
+			return;
+		throw std::runtime_error("Syntax error at line " + std::to_string(line) + ": cannot use a " + DataTypeToInternalTypeString(rvalue.dataType) + " with a " + DataTypeToInternalTypeString(lvalue.dataType) + ", only arrays or maps of the same type can be assigned to each other");
+	}
+
+	if (context.behavior.disableImplicitConversion && (lvalue.dataType != rvalue.dataType))
 		throw std::runtime_error("Invalid conversion (from " + DataTypeToInternalTypeString(rvalue.dataType) + " to " + DataTypeToInternalTypeString(lvalue.dataType) + ") at line " + std::to_string(line) + ": implicit conversions are disabled (disableImplicitConversion && lvalue.dataType != rvalue.dataType)\nremove the - disable_implicit_conversion argument to remove this error");
 
 	if (OneVariableIsString(lvalue, rvalue)) // no operator can be used if one is a string and the other is not (regardless of order)
@@ -895,16 +1330,21 @@ void Parser::CheckInstructionIntegrity(const Instruction& instruction, size_t in
 	CheckOperationIntegrity(op, instruction.operand1, instruction.operand2, index);
 }
 
-bool Parser::IsFunctionDeclaration(std::vector<Lexer::Token>& tokens)
+bool Parser::IsFunctionDeclaration(TokenSpan tokens)
 {
 	if (tokens.size() < 4)
 		return false;
-	return tokens[0].token == LEXER_TOKEN_DATATYPE && tokens[1].token == LEXER_TOKEN_IDENTIFIER && tokens[2].lexeme == LEXEME_OPEN_PARENTHESIS && tokens.back().lexeme == LEXEME_CLOSE_PARENTHESIS;
+	if (tokens[0].token == LEXER_TOKEN_DATATYPE && tokens[1].lexeme == LEXEME_OPEN_SBRACKET && tokens[2].lexeme == LEXEME_CLOSE_SBRACKET) // a function that returns an array
+		tokens = tokens.subspan(2);
+	return tokens.size() >= 4 && tokens[0].token == LEXER_TOKEN_DATATYPE && tokens[1].token == LEXER_TOKEN_IDENTIFIER && tokens[2].lexeme == LEXEME_OPEN_PARENTHESIS && tokens.back().lexeme == LEXEME_CLOSE_PARENTHESIS;
 }
 
-bool Parser::DoesFunctionExist(std::string name)
+bool Parser::DoesFunctionExist(ScriptContext& context, std::string_view name)
 {
-	return calledFunctions.count(name) > 0;
+	Symbol symbol = SymbolTable::Find(name);
+	if (!context.behavior.removeUnusedSymbols) // only then are the functions that are never called removed, a function that is only named in a string like for Generate or SortBy is one of them
+		return context.functionInfos.count(symbol) > 0;
+	return context.calledFunctions.count(symbol) > 0;
 }
 
 Lexeme Parser::InstructionTypeToLexemeOperator(InstructionType type)
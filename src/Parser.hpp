@@ -1,4 +1,5 @@
 #pragma once
+#include <span>
 #include <unordered_set>
 #include <unordered_map>
 #include "common.hpp"
@@ -6,7 +7,7 @@
 #include "Function.hpp"
 #include "StackFrame.hpp"
 
-typedef std::vector<std::vector<Lexer::Token>> FunctionBody;
+typedef std::span<const Lexer::Token> TokenSpan; // a view into the token array of a file, the parser never copies tokens
 
 struct AbstractSyntaxTree
 {
@@ -14,6 +15,35 @@ struct AbstractSyntaxTree
 	Function* entryPoint = nullptr;
 };
 
+enum ExpressionNodeType
+{
+	EXPRESSION_NODE_VALUE, // a variable or a literal
+	EXPRESSION_NODE_BINARY,
+	EXPRESSION_NODE_CALL,
+	EXPRESSION_NODE_LOCATION_OF,
+	EXPRESSION_NODE_DEREFERENCE,
+	EXPRESSION_NODE_INDEX, // an element of an array or a string
+};
+
+struct ExpressionNode
+{
+	ExpressionNodeType type = EXPRESSION_NODE_VALUE;
+	InstructionType operation = INSTRUCTION_TYPE_INVALID; // only for binary nodes
+	VariableInfo value{};      // the operand of a value, the function of a call or the variable of a location of / dereference, value.dataType is the type of the whole node
+	uint32_t left = 0;         // binary: the left child, call: the index of the first argument in ExpressionTree::arguments, index: the index
+	uint32_t right = 0;        // binary: the right child, call: the amount of arguments
+	uint32_t registerCount = 1; // the amount of calculation registers needed to calculate this node
+	bool containsCall = false;
+	int line = 0;
+};
+
+// the nodes of an expression are stored next to each other and refer to each other by index
+struct ExpressionTree
+{
+	std::vector<ExpressionNode> nodes;
+	std::vector<uint32_t> arguments;
+};
+
 struct StructInfo
 {
 	std::string name;
@@ -21,51 +51,76 @@ struct StructInfo
 	std::vector<VariableInfo> variables;
 };
 
+class ScriptContext;
+
+// a parser is made for every function body that is compiled, so the threads that compile bodies at the same time each simulate theirs in their own stack frame
+// everything it looks up about the other functions is in the context of the script that is compiled, which every entry point gets explicitly
 class Parser
 {
 public:
-	static AbstractSyntaxTree CreateAST(std::vector<Lexer::Token>& tokens);
-	static std::vector<FunctionInfo> GetAllFunctionInfos(std::vector<Lexer::Token>& tokens);
-	static void ParseTokens(FunctionBody& tokens, std::vector<Instruction>& ret, size_t& scopesTraversed);
+	static AbstractSyntaxTree CreateAST(ScriptContext& context, TokenSpan tokens);
+	static AbstractSyntaxTree CreateAST(ScriptContext& context, const std::vector<FunctionInfo>& infos); // for functions that were already collected, like the ones loaded from the bytecode cache
+	static std::vector<FunctionInfo> GetAllFunctionInfos(ScriptContext& context, TokenSpan tokens);
+	static std::vector<FunctionInfo> GetAllFunctionInfos(ScriptContext& context, const std::vector<TokenSpan>& modules); // the modules are linked through their function signatures, so their tokens never have to be merged
 
-	static std::vector<Instruction> GetInstructionsFromScopes(std::vector<std::vector<Lexer::Token>>& tokens);
+	static void CompileFunction(ScriptContext& context, FunctionInfo& info); // generates the instructions of a body that has not been compiled yet
+	static void AddToFunctionCache(ScriptContext& context, const std::vector<FunctionInfo>& infos); // compiled functions whose tokens did not change are reused instead of compiled again
 
-	static void GetInstructionsFromRValueRecursive(std::vector<Lexer::Token>& tokens, std::vector<Instruction>& destination, const VariableInfo& varToWriteTo);
-
-	static VariableInfo GetAssignVariableInfo(std::vector<Lexer::Token>& lvalue);
-	static FunctionInfo GetFunctionInfoFromTokens(std::vector<Lexer::Token>& tokens);
-	static bool IsFunctionDeclaration(std::vector<Lexer::Token>& tokens);
-	static bool DoesFunctionExist(std::string name);
+	static FunctionInfo GetFunctionInfoFromTokens(TokenSpan tokens);
+	static bool IsFunctionDeclaration(TokenSpan tokens);
+	static bool DoesFunctionExist(ScriptContext& context, std::string_view name);
 
 private:
-	static void ParseScope(FunctionBody& tokens, std::vector<Instruction>& ret, size_t& scopesTraversed);
-	static FunctionBody GetAllScopesFromBody(std::vector<Lexer::Token>& tokens);
+	Parser(ScriptContext& context);
+
+	static void CollectFunctionSignatures(ScriptContext& context, TokenSpan tokens, std::vector<FunctionInfo>& ret);
+	static void CompileFunctionBodies(ScriptContext& context, std::vector<FunctionInfo>& infos);
+	static bool ReuseCompiledFunction(ScriptContext& context, FunctionInfo& info);
+	static uint64_t GetDependencyHash(ScriptContext& context, const std::vector<Instruction>& instructions);
+
+	std::vector<Instruction> GetInstructionsFromFunctionBody(TokenSpan body);
+	void GetInstructionsFromRValue(TokenSpan tokens, size_t& index, std::vector<Instruction>& destination, const VariableInfo& varToWriteTo); // index is left on the first token after the rvalue
+	VariableInfo GetAssignVariableInfo(TokenSpan lvalue);
+
+	void ParseScope(TokenSpan tokens, std::vector<Instruction>& ret);
+	void ParseNestedScope(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret);
+
+	size_t ParseScopeDeclaration(TokenSpan tokens, std::vector<Instruction>& ret, size_t offset); // returns the index of where it left of
+	size_t ParseScopeOperator(TokenSpan tokens,    std::vector<Instruction>& ret, size_t offset);
+	size_t ParseScopeIdentifier(TokenSpan tokens,  std::vector<Instruction>& ret, size_t offset);
+	size_t ParseIndexedAssignment(TokenSpan tokens, std::vector<Instruction>& ret, size_t offset); // offset is the array, returns the index of where it left of
+
+	void GetConditionInstructions(TokenSpan condition, std::vector<Instruction>& ret);
 
-	static size_t ParseScopeDeclaration(const std::vector<Lexer::Token>& tokens, std::vector<Instruction>& ret, size_t offset); // returns the index of where it left of
-	static size_t ParseScopeOperator(std::vector<Lexer::Token>& tokens,          std::vector<Instruction>& ret, size_t offset);
-	static size_t ParseScopeIdentifier(const std::vector<Lexer::Token>& tokens,  std::vector<Instruction>& ret, size_t offset);
+	uint32_t ParseExpression(TokenSpan tokens, size_t& index, ExpressionTree& tree, int minimumPrecedence = 1);
+	uint32_t ParsePrimaryExpression(TokenSpan tokens, size_t& index, ExpressionTree& tree);
+	uint32_t ParseCallExpression(TokenSpan tokens, size_t& index, ExpressionTree& tree);
+	uint32_t CreateBinaryExpression(ExpressionTree& tree, const Lexer::Token& op, uint32_t left, uint32_t right);
 
-	static void GetFunctionPushInstructions(const std::vector<Lexer::Token>& tokens, size_t& index, std::vector<Instruction>& ret);
-	static void GetConditionInstructions(std::vector<Lexer::Token>& tokens, size_t index, std::vector<Instruction>& ret);
+	void LowerExpression(const ExpressionTree& tree, uint32_t node, const VariableInfo& destination, size_t firstFreeRegister, std::vector<Instruction>& ret);
+	void LowerCallExpression(const ExpressionTree& tree, uint32_t node, size_t firstFreeRegister, std::vector<Instruction>& ret);
+	VariableInfo GetExpressionOperand(const ExpressionTree& tree, uint32_t node, size_t firstFreeRegister, std::vector<Instruction>& ret);
 
-	static void ProcessKeyword(std::vector<std::vector<Lexer::Token>>& tokens, size_t scopeIndex, size_t& scopesTraversed, size_t& i, std::vector<Instruction>& ret);
-	static void ProcessIfStatement(std::vector<std::vector<Lexer::Token>>& tokens, size_t scopeIndex, size_t& scopesTraversed, size_t& i, std::vector<Instruction>& ret);
-	static void ProcessWhileStatement(std::vector<std::vector<Lexer::Token>>& tokens, size_t scopeIndex, size_t& scopesTraversed, size_t& i, std::vector<Instruction>& ret);
-	static void ProcessForStatement(std::vector<std::vector<Lexer::Token>>& tokens, size_t scopeIndex, size_t& scopesTraversed, size_t& i, std::vector<Instruction>& ret);
-	static void ProcessReturnStatement(std::vector<Lexer::Token>& tokens, size_t& i, std::vector<Instruction>& ret);
-	static void ProcessLocationOfOperator(const std::vector<Lexer::Token>& tokens, size_t& i, Instruction& instruction);
-	static void ProcessDereferenceOperator(const std::vector<Lexer::Token>& tokens, size_t& i, Instruction& instruction);
+	void ProcessKeyword(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret);
+	void ProcessIfStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret);
+	void ProcessWhileStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret);
+	void ProcessForStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret);
+	void ProcessParallelForStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret);
+	bool IsSharedVariable(Symbol variable); // declared outside of the body of the parallel for that is parsed, the iterations can only read it
+	bool IsSharedMap(Symbol variable); // a map that the iterations of a parallel for must not change, a map declared in the body belongs to one iteration
+	void ProcessReturnStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret);
+	void ProcessYieldStatement(TokenSpan tokens, size_t& i, std::vector<Instruction>& ret);
 
-	static void GetInstructionsForLexemeEqualsOperator(const Lexer::Token& op, const VariableInfo& varToWriteTo, std::vector<Instruction>& instructions);
+	void GetInstructionsForLexemeEqualsOperator(const Lexer::Token& op, const VariableInfo& varToWriteTo, const VariableInfo& varToReadFrom, DataType readType, std::vector<Instruction>& instructions);
 
-	static void CheckOpenCloseIntegrityPremature(const std::vector<Lexer::Token>& tokens);
-	static void CheckOperationIntegrity(const Lexeme op, const VariableInfo& lvalue, const VariableInfo& rvalue, size_t line);
-	static void CheckInstructionIntegrity(const Instruction& instruction, size_t index);
+	static void CheckOpenCloseIntegrityPremature(TokenSpan tokens);
+	void CheckOperationIntegrity(const Lexeme op, const VariableInfo& lvalue, const VariableInfo& rvalue, size_t line);
+	void CheckInstructionIntegrity(const Instruction& instruction, size_t index);
 	static Lexeme InstructionTypeToLexemeOperator(InstructionType type);
 
-	static void ReplaceTokensForSpecialOperator(size_t index, std::vector<Lexer::Token>& tokens);
+	static Lexer::Token GetEqualsOperatorForSpecialOperator(const Lexer::Token& op);
 
-	static StackFrame simulationStackFrame;
-	static std::unordered_map<std::string, FunctionInfo> functionInfos;
-	static std::unordered_set<std::string> calledFunctions;
+	ScriptContext& context;
+	StackFrame simulationStackFrame;
+	size_t sharedScopeCount = 0; // in the body of a parallel for, the variables of this many outer scopes are shared by the iterations
 };
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include "SIMD.hpp"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_USE_SSE2
+#endif
+
+// every kernel handles as many elements as it can with SIMD instructions, the loop after it handles the rest (or everything if there is no SSE2)
+
+#ifdef SIMD_USE_SSE2
+inline float HorizontalSum(__m128 values)
+{
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, values);
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+inline int HorizontalSum(__m128i values)
+{
+	alignas(16) uint32_t lanes[4];
+	_mm_store_si128((__m128i*)lanes, values);
+	return (int)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+
+inline __m128i MultiplyInts(__m128i left, __m128i right) // _mm_mullo_epi32 needs SSE4.1, the low 32 bits of the products are the same for signed and unsigned ints
+{
+	__m128i even = _mm_mul_epu32(left, right);
+	__m128i odd = _mm_mul_epu32(_mm_srli_si128(left, 4), _mm_srli_si128(right, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+inline __m128i SelectInts(__m128i mask, __m128i ifSet, __m128i ifNotSet) // _mm_blendv_epi8 needs SSE4.1
+{
+	return _mm_or_si128(_mm_and_si128(mask, ifSet), _mm_andnot_si128(mask, ifNotSet));
+}
+#endif
+
+int SIMD::Sum(const int* values, size_t count)
+{
+	size_t i = 0;
+	uint32_t ret = 0;
+#ifdef SIMD_USE_SSE2
+	__m128i sum = _mm_setzero_si128();
+	for (; i + 4 <= count; i += 4)
+		sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i*)(values + i)));
+	ret = (uint32_t)HorizontalSum(sum);
+#endif
+	for (; i < count; i++)
+		ret += (uint32_t)values[i];
+	return (int)ret;
+}
+
+float SIMD::Sum(const float* values, size_t count)
+{
+	size_t i = 0;
+	float ret = 0;
+#ifdef SIMD_USE_SSE2
+	__m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps(); // two sums, so that an addition does not have to wait for the previous one
+	for (; i + 8 <= count; i += 8)
+	{
+		sum0 = _mm_add_ps(sum0, _mm_loadu_ps(values + i));
+		sum1 = _mm_add_ps(sum1, _mm_loadu_ps(values + i + 4));
+	}
+	ret = HorizontalSum(_mm_add_ps(sum0, sum1));
+#endif
+	for (; i < count; i++)
+		ret += values[i];
+	return ret;
+}
+
+int SIMD::Min(const int* values, size_t count)
+{
+	size_t i = 1;
+	int ret = values[0];
+#ifdef SIMD_USE_SSE2
+	if (count >= 4)
+	{
+		__m128i min = _mm_loadu_si128((const __m128i*)values);
+		for (i = 4; i + 4 <= count; i += 4)
+		{
+			__m128i current = _mm_loadu_si128((const __m128i*)(values + i));
+			min = SelectInts(_mm_cmplt_epi32(current, min), current, min);
+		}
+		alignas(16) int lanes[4];
+		_mm_store_si128((__m128i*)lanes, min);
+		ret = *std::min_element(lanes, lanes + 4);
+	}
+#endif
+	for (; i < count; i++)
+		ret = std::min(ret, values[i]);
+	return ret;
+}
+
+float SIMD::Min(const float* values, size_t count)
+{
+	size_t i = 1;
+	float ret = values[0];
+#ifdef SIMD_USE_SSE2
+	if (count >= 4)
+	{
+		__m128 min = _mm_loadu_ps(values);
+		for (i = 4; i + 4 <= count; i += 4)
+			min = _mm_min_ps(min, _mm_loadu_ps(values + i));
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, min);
+		ret = *std::min_element(lanes, lanes + 4);
+	}
+#endif
+	for (; i < count; i++)
+		ret = std::min(ret, values[i]);
+	return ret;
+}
+
+int SIMD::Max(const int* values, size_t count)
+{
+	size_t i = 1;
+	int ret = values[0];
+#ifdef SIMD_USE_SSE2
+	if (count >= 4)
+	{
+		__m128i max = _mm_loadu_si128((const __m128i*)values);
+		for (i = 4; i + 4 <= count; i += 4)
+		{
+			__m128i current = _mm_loadu_si128((const __m128i*)(values + i));
+			max = SelectInts(_mm_cmpgt_epi32(current, max), current, max);
+		}
+		alignas(16) int lanes[4];
+		_mm_store_si128((__m128i*)lanes, max);
+		ret = *std::max_element(lanes, lanes + 4);
+	}
+#endif
+	for (; i < count; i++)
+		ret = std::max(ret, values[i]);
+	return ret;
+}
+
+float SIMD::Max(const float* values, size_t count)
+{
+	size_t i = 1;
+	float ret = values[0];
+#ifdef SIMD_USE_SSE2
+	if (count >= 4)
+	{
+		__m128 max = _mm_loadu_ps(values);
+		for (i = 4; i + 4 <= count; i += 4)
+			max = _mm_max_ps(max, _mm_loadu_ps(values + i));
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, max);
+		ret = *std::max_element(lanes, lanes + 4);
+	}
+#endif
+	for (; i < count; i++)
+		ret = std::max(ret, values[i]);
+	return ret;
+}
+
+int SIMD::Dot(const int* left, const int* right, size_t count)
+{
+	size_t i = 0;
+	uint32_t ret = 0;
+#ifdef SIMD_USE_SSE2
+	__m128i sum = _mm_setzero_si128();
+	for (; i + 4 <= count; i += 4)
+		sum = _mm_add_epi32(sum, MultiplyInts(_mm_loadu_si128((const __m128i*)(left + i)), _mm_loadu_si128((const __m128i*)(right + i))));
+	ret = (uint32_t)HorizontalSum(sum);
+#endif
+	for (; i < count; i++)
+		ret += (uint32_t)left[i] * (uint32_t)right[i];
+	return (int)ret;
+}
+
+float SIMD::Dot(const float* left, const float* right, size_t count)
+{
+	size_t i = 0;
+	float ret = 0;
+#ifdef SIMD_USE_SSE2
+	__m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+	for (; i + 8 <= count; i += 8)
+	{
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(left + i), _mm_loadu_ps(right + i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(left + i + 4), _mm_loadu_ps(right + i + 4)));
+	}
+	ret = HorizontalSum(_mm_add_ps(sum0, sum1));
+#endif
+	for (; i < count; i++)
+		ret += left[i] * right[i];
+	return ret;
+}
+
+void SIMD::Scale(int* values, int factor, size_t count)
+{
+	size_t i = 0;
+#ifdef SIMD_USE_SSE2
+	__m128i factors = _mm_set1_epi32(factor);
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128((__m128i*)(values + i), MultiplyInts(_mm_loadu_si128((const __m128i*)(values + i)), factors));
+#endif
+	for (; i < count; i++)
+		values[i] = (int)((uint32_t)values[i] * (uint32_t)factor);
+}
+
+void SIMD::Scale(float* values, float factor, size_t count)
+{
+	size_t i = 0;
+#ifdef SIMD_USE_SSE2
+	__m128 factors = _mm_set1_ps(factor);
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(values + i, _mm_mul_ps(_mm_loadu_ps(values + i), factors));
+#endif
+	for (; i < count; i++)
+		values[i] *= factor;
+}
+
+void SIMD::Add(int* destination, const int* source, size_t count)
+{
+	size_t i = 0;
+#ifdef SIMD_USE_SSE2
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128((__m128i*)(destination + i), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(destination + i)), _mm_loadu_si128((const __m128i*)(source + i))));
+#endif
+	for (; i < count; i++)
+		destination[i] = (int)((uint32_t)destination[i] + (uint32_t)source[i]);
+}
+
+void SIMD::Add(float* destination, const float* source, size_t count)
+{
+	size_t i = 0;
+#ifdef SIMD_USE_SSE2
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i), _mm_loadu_ps(source + i)));
+#endif
+	for (; i < count; i++)
+		destination[i] += source[i];
+}
+
+void SIMD::Sqrt(float* values, size_t count)
+{
+	size_t i = 0;
+#ifdef SIMD_USE_SSE2
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(values + i, _mm_sqrt_ps(_mm_loadu_ps(values + i)));
+#endif
+	for (; i < count; i++)
+		values[i] = std::sqrt(values[i]);
+}
+
+float SIMD::SquaredDeviationSum(const float* values, size_t count, float mean)
+{
+	size_t i = 0;
+	float ret = 0;
+#ifdef SIMD_USE_SSE2
+	__m128 means = _mm_set1_ps(mean), sum = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 deviation = _mm_sub_ps(_mm_loadu_ps(values + i), means);
+		sum = _mm_add_ps(sum, _mm_mul_ps(deviation, deviation));
+	}
+	ret = HorizontalSum(sum);
+#endif
+	for (; i < count; i++)
+		ret += (values[i] - mean) * (values[i] - mean);
+	return ret;
+}
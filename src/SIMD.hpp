@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+
+// the kernels behind the bulk operations on arrays, so that whole arrays are processed without going through the interpreter for every element
+// they use SSE2, which every x86-64 cpu has, and fall back to plain loops on other targets, int arithmetic wraps around like it does on the cpu
+namespace SIMD
+{
+	inline extern int   Sum(const int* values, size_t count);
+	inline extern float Sum(const float* values, size_t count);
+	inline extern int   Min(const int* values, size_t count); // count has to be at least 1
+	inline extern float Min(const float* values, size_t count);
+	inline extern int   Max(const int* values, size_t count);
+	inline extern float Max(const float* values, size_t count);
+	inline extern int   Dot(const int* left, const int* right, size_t count);
+	inline extern float Dot(const float* left, const float* right, size_t count);
+	inline extern void  Scale(int* values, int factor, size_t count);
+	inline extern void  Scale(float* values, float factor, size_t count);
+	inline extern void  Add(int* destination, const int* source, size_t count);
+	inline extern void  Add(float* destination, const float* source, size_t count);
+	inline extern void  Sqrt(float* values, size_t count);
+	inline extern float SquaredDeviationSum(const float* values, size_t count, float mean); // the sum of (value - mean)^2
+}
@@ -0,0 +1,193 @@
+#include <cstdint>
+#include "Scanner.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SCANNER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#endif
+#endif
+
+// this has to match Lexer::IsSeperator and Lexer::IsOperator, with the start of a comment and a string literal added
+constexpr char specialCharacters[] =
+{
+	' ', ',', ';', '(', ')', '{', '}', '\n', '\t', '\r', // seperators
+	'-', '+', '/', '*', '=', '%', '!', '[', ']', '&',    // operators
+	'#', '\"',
+};
+
+struct SpecialCharacterTable
+{
+	constexpr SpecialCharacterTable()
+	{
+		for (char special : specialCharacters)
+			isSpecial[(unsigned char)special] = true;
+	}
+	bool isSpecial[256] = {};
+};
+constexpr SpecialCharacterTable specialCharacterTable;
+
+inline const char* FindNextSpecialCharacterScalar(const char* begin, const char* end)
+{
+	for (; begin < end; begin++)
+		if (specialCharacterTable.isSpecial[(unsigned char)*begin])
+			return begin;
+	return end;
+}
+
+inline size_t CountNewlinesScalar(const char* begin, const char* end)
+{
+	size_t ret = 0;
+	for (; begin < end; begin++)
+		ret += *begin == '\n';
+	return ret;
+}
+
+#ifdef SCANNER_X86
+inline int CountTrailingZeros(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+inline int PopCount16(uint32_t mask) // not every cpu with SSE2 has the popcnt instruction
+{
+	mask = mask - ((mask >> 1) & 0x5555);
+	mask = (mask & 0x3333) + ((mask >> 2) & 0x3333);
+	mask = (mask + (mask >> 4)) & 0x0F0F;
+	return (int)((mask + (mask >> 8)) & 0x1F);
+}
+
+TARGET_SSE2 inline const char* FindNextSpecialCharacterSSE2(const char* begin, const char* end)
+{
+	for (; end - begin >= 16; begin += 16)
+	{
+		__m128i block = _mm_loadu_si128((const __m128i*)begin);
+		__m128i matches = _mm_setzero_si128();
+		for (char special : specialCharacters) // the compiler unrolls this into a compare per special character
+			matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, _mm_set1_epi8(special)));
+
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(matches);
+		if (mask != 0)
+			return begin + CountTrailingZeros(mask);
+	}
+	return FindNextSpecialCharacterScalar(begin, end); // the tail does not fill a whole block
+}
+
+TARGET_SSE2 inline size_t CountNewlinesSSE2(const char* begin, const char* end)
+{
+	const __m128i newline = _mm_set1_epi8('\n');
+	size_t ret = 0;
+	for (; end - begin >= 16; begin += 16)
+		ret += PopCount16((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)begin), newline)));
+	return ret + CountNewlinesScalar(begin, end);
+}
+
+TARGET_AVX2 inline const char* FindNextSpecialCharacterAVX2(const char* begin, const char* end)
+{
+	for (; end - begin >= 32; begin += 32)
+	{
+		__m256i block = _mm256_loadu_si256((const __m256i*)begin);
+		__m256i matches = _mm256_setzero_si256();
+		for (char special : specialCharacters)
+			matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(special)));
+
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(matches);
+		if (mask != 0)
+			return begin + CountTrailingZeros(mask);
+	}
+	return FindNextSpecialCharacterSSE2(begin, end);
+}
+
+TARGET_AVX2 inline size_t CountNewlinesAVX2(const char* begin, const char* end)
+{
+	const __m256i newline = _mm256_set1_epi8('\n');
+	size_t ret = 0;
+	for (; end - begin >= 32; begin += 32)
+		ret += _mm_popcnt_u32((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)begin), newline)));
+	return ret + CountNewlinesSSE2(begin, end);
+}
+#endif
+
+enum InstructionSet
+{
+	INSTRUCTION_SET_SCALAR,
+	INSTRUCTION_SET_SSE2,
+	INSTRUCTION_SET_AVX2,
+};
+
+inline InstructionSet GetSupportedInstructionSet()
+{
+#if defined(SCANNER_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int highestLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool hasSSE2 = (info[3] & (1 << 26)) != 0;
+	bool hasPopcnt = (info[2] & (1 << 23)) != 0; // the AVX2 path counts newlines with it
+	bool osSavesYMM = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6; // AVX registers can only be used if the OS saves them on a context switch
+	if (highestLeaf >= 7 && osSavesYMM && hasPopcnt)
+	{
+		__cpuidex(info, 7, 0);
+		if ((info[1] & (1 << 5)) != 0)
+			return INSTRUCTION_SET_AVX2;
+	}
+	if (hasSSE2)
+		return INSTRUCTION_SET_SSE2;
+#elif defined(SCANNER_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) // the AVX2 path counts newlines with popcnt
+		return INSTRUCTION_SET_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return INSTRUCTION_SET_SSE2;
+#endif
+	return INSTRUCTION_SET_SCALAR;
+}
+
+struct ScannerFunctions
+{
+	const char* (*findNextSpecialCharacter)(const char*, const char*) = FindNextSpecialCharacterScalar;
+	size_t (*countNewlines)(const char*, const char*) = CountNewlinesScalar;
+	const char* name = "scalar";
+};
+
+inline ScannerFunctions GetScannerFunctions()
+{
+	switch (GetSupportedInstructionSet())
+	{
+#ifdef SCANNER_X86
+	case INSTRUCTION_SET_AVX2: return { FindNextSpecialCharacterAVX2, CountNewlinesAVX2, "AVX2" };
+	case INSTRUCTION_SET_SSE2: return { FindNextSpecialCharacterSSE2, CountNewlinesSSE2, "SSE2" };
+#endif
+	}
+	return {};
+}
+
+static const ScannerFunctions scannerFunctions = GetScannerFunctions();
+
+const char* Scanner::FindNextSpecialCharacter(const char* begin, const char* end)
+{
+	return scannerFunctions.findNextSpecialCharacter(begin, end);
+}
+
+size_t Scanner::CountNewlines(const char* begin, const char* end)
+{
+	return scannerFunctions.countNewlines(begin, end);
+}
+
+const char* Scanner::GetInstructionSetName()
+{
+	return scannerFunctions.name;
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+
+// vectorized helpers for the lexer that look at 16 (SSE2) or 32 (AVX2) bytes of the input at once instead of a single char
+// the widest instruction set the cpu supports is picked once at runtime, other cpus use a scalar fallback
+namespace Scanner
+{
+	// returns the first seperator, operator, '#' or '"' in [begin, end) or end if there is none, this is the next char that the lexer has to look at
+	inline extern const char* FindNextSpecialCharacter(const char* begin, const char* end);
+	inline extern size_t CountNewlines(const char* begin, const char* end);
+	inline extern const char* GetInstructionSetName();
+}
\ No newline at end of file
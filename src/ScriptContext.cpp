@@ -0,0 +1,138 @@
+#include <iostream>
+#include <stdexcept>
+#include "ScriptContext.hpp"
+#include "Parser.hpp"
+#include "Interpreter.hpp"
+#include "std.hpp"
+#include "Behavior.hpp"
+#include "Debug.hpp"
+#include "MappedFile.hpp"
+#include "Scanner.hpp"
+#include "BytecodeCache.hpp"
+#include "ModuleGraph.hpp"
+#include "Parallel.hpp"
+
+static thread_local ScriptContext* currentContext = nullptr;
+
+ScriptContext::ScriptContext(const Behavior& behavior) : behavior(behavior), output(behavior.outputBuffering), input(output) {}
+
+ScriptContext::~ScriptContext()
+{
+	for (auto& [name, function] : functions)
+		delete function;
+}
+
+void ScriptContext::Run(const std::string& inputPath)
+{
+	Binding binding(this);
+	MappedFile source(inputPath); // the tokens point directly into the mapped files, so every file has to stay mapped until the script ends
+	std::string_view input = source.View();
+
+	bool usesCache = behavior.bytecodeCache && !behavior.dumpTokens && !behavior.dumpStackFrame; // these dumps are made while lexing and parsing
+	std::unique_ptr<ModuleGraph> modules; // lazily compiled functions point into the tokens of the modules, so they have to live until execution ends
+	std::vector<FunctionInfo> infos;
+	if (!usesCache || !BytecodeCache::Load(behavior, inputPath, input, infos, importedFiles))
+	{
+		Parser::AddToFunctionCache(*this, infos); // an outdated cache still has the functions that did not change
+		if (behavior.verbose)
+			std::cout << "Lexing with the " << Scanner::GetInstructionSetName() << " scanner\n";
+		modules = std::make_unique<ModuleGraph>(behavior, inputPath, input);
+		std::vector<TokenSpan> tokens = modules->GetTokensInImportOrder();
+		std::vector<std::string> imports = modules->GetImportedFiles();
+		importedFiles.insert(importedFiles.end(), imports.begin(), imports.end());
+
+		if (behavior.dumpTokens)
+		{
+			for (TokenSpan moduleTokens : tokens)
+				for (Lexer::Token token : moduleTokens)
+					std::cout << Debug::DumpToken(token) << "\n";
+			return;
+		}
+
+		infos = Parser::GetAllFunctionInfos(*this, tokens);
+		if (usesCache)
+			BytecodeCache::Save(behavior, inputPath, input, infos, importedFiles);
+	}
+
+	AbstractSyntaxTree tree = Parser::CreateAST(*this, infos);
+	if (behavior.verbose)
+	{
+		std::cout << "Processed functions:\n";
+		for (Function* fn : tree.functions)
+			std::cout << "  " << fn->GetName() << ",\n";
+			
+		if (tree.entryPoint != nullptr)
+			std::cout << "Using " << tree.entryPoint->GetName() << " as entry point\n\n";
+	}
+
+	Interpreter& interpreter = GetInterpreter();
+	Interpreter::SetAST(*this, tree);
+
+	StandardLib::Init(*this);
+
+	if (tree.entryPoint == nullptr && !behavior.dumpFunctionInstructions && !behavior.dumpStackFrame)
+		throw std::runtime_error("Failed to find the entry point, create a function named \"main()\" or define a custom entry point with the command argument -entry_point");
+
+	if (!behavior.dumpFunctionInstructions && !behavior.dumpStackFrame) // dumping instructions means no code gets executed
+		tree.entryPoint->ExecuteBody(interpreter);
+}
+
+Interpreter& ScriptContext::GetInterpreter()
+{
+	std::lock_guard<std::mutex> lock(interpretersMutex);
+	std::unique_ptr<Interpreter>& interpreter = interpreters[std::this_thread::get_id()];
+	if (interpreter == nullptr)
+		interpreter = std::make_unique<Interpreter>(*this);
+	return *interpreter;
+}
+
+ScriptContext& ScriptContext::Current()
+{
+	if (currentContext == nullptr)
+		throw std::runtime_error("There is no script running on this thread");
+	return *currentContext;
+}
+
+ScriptContext* ScriptContext::Find()
+{
+	return currentContext;
+}
+
+ScriptContext::Binding::Binding(ScriptContext* context) : previous(currentContext), context(context)
+{
+	currentContext = context;
+	if (context == nullptr)
+		return;
+	std::lock_guard<std::mutex> lock(context->waitMutex);
+	context->threadCount++;
+}
+
+ScriptContext::Binding::~Binding()
+{
+	currentContext = previous;
+	if (context == nullptr)
+		return;
+	std::lock_guard<std::mutex> lock(context->waitMutex);
+	context->threadCount--;
+	context->CheckForDeadlock(); // the thread could have been the one that the others wait for
+}
+
+void ScriptContext::BeginWait()
+{
+	waitingThreadCount++;
+	CheckForDeadlock();
+}
+
+void ScriptContext::EndWait()
+{
+	if (--waitingThreadCount == 0)
+		isDeadlocked = false;
+}
+
+void ScriptContext::CheckForDeadlock()
+{
+	if (threadCount == 0 || waitingThreadCount < threadCount || Parallel::HasUnstartedTasks(this))
+		return;
+	isDeadlocked = true;
+	waitChanged.notify_all();
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include "Function.hpp"
+#include "NativeFunction.hpp"
+#include "FileIO.hpp"
+#include "Generator.hpp"
+#include "Channel.hpp"
+#include "Behavior.hpp"
+#include "Output.hpp"
+#include "Input.hpp"
+
+// everything that belongs to one script: the command arguments it runs with, its output and input, what the parser knows about its functions, the functions themselves, the files it imported and the files, generators and channels it opened
+// several scripts can run in one process at the same time, as long as each of them has its own context and runs on its own thread
+// the parser, the standard library and the native functions are handed the context they work on, the threads that a script starts itself share its context
+// every thread that runs instructions of the script gets its own Interpreter from the context, which keeps its stack and registers apart from those of other scripts on the same thread
+// only the symbol table is shared by every script in the process
+class ScriptContext
+{
+public:
+	explicit ScriptContext(const Behavior& behavior = {});
+	ScriptContext(const ScriptContext&) = delete;
+	ScriptContext& operator=(const ScriptContext&) = delete;
+	~ScriptContext();
+
+	void Run(const std::string& inputPath); // lexes, parses and runs the script and its imports, a context runs only one script
+
+	Interpreter& GetInterpreter(); // of the calling thread, made the first time the thread runs instructions of this script
+
+	static ScriptContext& Current(); // throws if the calling thread does not work on a script
+	static ScriptContext* Find();    // nullptr if the calling thread does not work on a script
+
+	class Binding // makes a context the current one of the calling thread for as long as it exists, it counts as one of the threads that work on the script
+	{
+	public:
+		Binding(ScriptContext* context);
+		~Binding();
+
+	private:
+		ScriptContext* previous;
+		ScriptContext* context;
+	};
+
+	// a thread that waits for a channel or for the other threads of a parallel for does so on waitChanged between BeginWait and EndWait, all three are called with waitMutex held
+	// once every thread of the script waits and no iteration is left for a new thread, no wait can end anymore, so the ones for channels are woken to throw
+	void BeginWait();
+	void EndWait();
+	void CheckForDeadlock();
+
+	const Behavior behavior;
+	Output output; // flushed when the context is destroyed
+	Input input;
+
+	std::unordered_map<Symbol, FunctionInfo> functionInfos;
+	std::unordered_set<Symbol> calledFunctions;
+	std::unordered_map<uint64_t, FunctionInfo> compiledFunctionCache; // by the hash of their tokens
+	std::mutex compilationMutex; // the parser keeps track of the called functions, so only one body is compiled at a time
+
+	std::unordered_map<Symbol, Function*> functions; // owned by the context
+	std::unordered_map<Symbol, NativeFunction> nativeFunctions;
+
+	std::unordered_map<std::thread::id, std::unique_ptr<Interpreter>> interpreters; // the threads of the pool keep theirs until the context is destroyed
+	std::mutex interpretersMutex; // only held to find the interpreter of a thread, once per script, block of a parallel for, generator step or sort
+
+	std::vector<std::string> importedFiles;
+	std::vector<std::unique_ptr<OpenFile>> files;
+	std::mutex filesMutex; // the iterations of a parallel for can open, read and write files at the same time
+	std::vector<std::shared_ptr<Generator>> generators; // a thread that runs a generator keeps it alive even if another one stops it
+	std::mutex generatorsMutex;                          // only held to find a generator, not while its body runs
+	std::vector<std::shared_ptr<Channel>> channels; // a thread that waits for a channel keeps it alive even if another one closes it
+	std::shared_mutex channelsMutex;                // only held to find a channel, not while sending or receiving
+
+	std::mutex waitMutex;
+	std::condition_variable waitChanged; // notified when a channel that is waited for got a value or space, was closed, or when a deadlock was found
+	size_t threadCount = 0;
+	size_t waitingThreadCount = 0;
+	bool isDeadlocked = false; // until no thread waits anymore
+};
@@ -15,6 +15,11 @@ void Stack::CreateNewStackFrame()
 	stack.push_back({});
 }
 
+void Stack::CreateNewStackFrame(StackFrame frame)
+{
+	stack.push_back(std::move(frame));
+}
+
 StackFrame& Stack::operator[](size_t index)
 {
 	return stack[index];
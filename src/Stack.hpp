@@ -7,6 +7,7 @@ public:
 	Stack();
 	void GotoEnclosingStackFrame();
 	void CreateNewStackFrame();
+	void CreateNewStackFrame(StackFrame frame); // starts with the variables and scopes of frame
 
 	StackFrame& operator[](size_t index);
 	StackFrame& Last();
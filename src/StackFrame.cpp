@@ -1,6 +1,5 @@
 #include <iostream>
 #include "StackFrame.hpp"
-#include "Behavior.hpp"
 #include "Debug.hpp"
 
 StackFrame::StackFrame()
@@ -20,7 +19,7 @@ void StackFrame::IncrementScope()
 
 void StackFrame::DecrementScope()
 {
-	if (Behavior::dumpStackFrame && firstPop)
+	if (isDumped && firstPop)
 	{
 		std::cout << Debug::DumpStackFrame(this) << "\n";
 		firstPop = false;
@@ -39,7 +38,7 @@ const Scope& StackFrame::At(size_t index) const
 	return scopes[index];
 }
 
-Variable& StackFrame::operator[](std::string index)
+Variable& StackFrame::operator[](Symbol index)
 {
 	for (Scope& scope : scopes)
 		if (scope.count(index) > 0)
@@ -47,15 +46,20 @@ Variable& StackFrame::operator[](std::string index)
 	return scopes.back()[index];
 }
 
-Variable& StackFrame::GetVariable(std::string var)
+Variable& StackFrame::GetVariable(Symbol var)
 {
 	for (Scope& scope : scopes)
 		if (scope.count(var) > 0)
 			return scope[var];
-	throw std::runtime_error("Cannot find variable \"" + var + "\" in the current stack frame");
+	throw std::runtime_error("Cannot find variable \"" + SymbolTable::GetName(var) + "\" in the current stack frame");
 }
 
-bool StackFrame::Has(std::string var)
+Variable& StackFrame::GetCalculationRegister(Symbol reg)
+{
+	return calculationRegisters[reg - SYMBOL_FLOAT_CALCULATION_VAR];
+}
+
+bool StackFrame::Has(Symbol var)
 {
 	for (Scope& scope : scopes)
 		if (scope.count(var) > 0)
@@ -67,7 +71,7 @@ void StackFrame::Clear()
 {
 	scopes.clear();
 	IncrementScope(); // always keep one scope alive
-	if (Behavior::dumpStackFrame && firstPop)
+	if (isDumped && firstPop)
 	{
 		std::cout << Debug::DumpStackFrame(this) << "\n";
 		firstPop = false;
@@ -75,7 +79,7 @@ void StackFrame::Clear()
 	firstPop = true;
 }
 
-MemoryLocation StackFrame::EncodeVariableIntoLocation(std::string variable)
+MemoryLocation StackFrame::EncodeVariableIntoLocation(Symbol variable)
 {
 	if (!Has(variable))
 		throw std::runtime_error("Memory error: cannot encode variable, because it does not exist in the current stack frame");
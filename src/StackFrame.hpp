@@ -4,7 +4,7 @@
 #include <vector>
 #include "common.hpp"
 
-typedef std::map<std::string, Variable> Scope;
+typedef std::map<Symbol, Variable> Scope;
 
 // memory locations are sort of an alternative to pointers, where a memory location contains the scopes location and the variables location within that scope
 // they can be encoded so that it contains both the index of the scope of the current stack frame and the index of the variable inside that scope
@@ -23,16 +23,20 @@ public:
 	size_t Size() const;
 
 	Variable& GetVariableAtMemoryLocation(MemoryLocation location);
-	MemoryLocation EncodeVariableIntoLocation(std::string variable);
+	MemoryLocation EncodeVariableIntoLocation(Symbol variable);
 	static void DecodeMemoryLocation(MemoryLocation location, uint16_t& stackIndex, uint16_t& scopeIndex);
 	
-	bool Has(std::string var);
+	bool Has(Symbol var);
 
 	const Scope& At(size_t index) const;
-	Variable& operator[](std::string index);
-	Variable& GetVariable(std::string var);
+	Variable& operator[](Symbol index);
+	Variable& GetVariable(Symbol var);
+	Variable& GetCalculationRegister(Symbol reg);
+
+	bool isDumped = false; // printed the first time a scope is left, the parser sets this for -dump_stack_frames
 
 private:
 	std::vector<Scope> scopes;
+	Variable calculationRegisters[CALCULATION_REGISTER_COUNT];
 	bool firstPop = true; // for debug
 };
\ No newline at end of file
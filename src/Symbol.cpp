@@ -0,0 +1,70 @@
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <stdexcept>
+#include "Symbol.hpp"
+
+// in the same order as ReservedSymbol
+constexpr std::string_view reservedSymbolNames[] = { "", "%fsv", "%frv", "%lbv", "%rbv", "%bpv", "%aiv", "%fcv", "%cr1", "%cr2", "%cr3", "%cr4", "%cr5", "%cr6", "%cr7" };
+static_assert(sizeof(reservedSymbolNames) / sizeof(reservedSymbolNames[0]) == SYMBOL_FIRST_USER_SYMBOL, "every reserved symbol needs a name");
+
+struct SymbolStorage
+{
+	SymbolStorage()
+	{
+		for (std::string_view name : reservedSymbolNames)
+			Insert(name);
+	}
+
+	Symbol Insert(std::string_view name)
+	{
+		Symbol ret = (Symbol)names.size();
+		const std::string& storedName = names.emplace_back(name); // a deque never moves its elements, so the key can safely be a view into the stored name
+		symbols.insert({ storedName, ret });
+		return ret;
+	}
+
+	std::deque<std::string> names;
+	std::unordered_map<std::string_view, Symbol> symbols;
+	std::shared_mutex mutex;
+};
+
+inline SymbolStorage& GetSymbolStorage()
+{
+	static SymbolStorage storage;
+	return storage;
+}
+
+Symbol SymbolTable::Intern(std::string_view name)
+{
+	SymbolStorage& storage = GetSymbolStorage();
+	{
+		std::shared_lock<std::shared_mutex> lock(storage.mutex); // almost every name is already interned, so most calls never need exclusive access
+		auto iter = storage.symbols.find(name);
+		if (iter != storage.symbols.end())
+			return iter->second;
+	}
+	std::unique_lock<std::shared_mutex> lock(storage.mutex);
+	auto iter = storage.symbols.find(name); // another thread could have interned the same name in the meantime
+	if (iter != storage.symbols.end())
+		return iter->second;
+	return storage.Insert(name);
+}
+
+Symbol SymbolTable::Find(std::string_view name)
+{
+	SymbolStorage& storage = GetSymbolStorage();
+	std::shared_lock<std::shared_mutex> lock(storage.mutex);
+	auto iter = storage.symbols.find(name);
+	return iter != storage.symbols.end() ? iter->second : SYMBOL_NONE;
+}
+
+const std::string& SymbolTable::GetName(Symbol symbol)
+{
+	SymbolStorage& storage = GetSymbolStorage();
+	std::shared_lock<std::shared_mutex> lock(storage.mutex);
+	if (symbol >= storage.names.size())
+		throw std::runtime_error("Invalid symbol " + std::to_string(symbol));
+	return storage.names[symbol];
+}
\ No newline at end of file
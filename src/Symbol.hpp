@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// every identifier is interned into one global table by the lexer and is only referred to by its id from then on
+// comparing or hashing an id is a lot cheaper than doing the same with a string, the name itself is only needed for diagnostics and reflection
+typedef uint32_t Symbol;
+
+enum ReservedSymbol : Symbol
+{
+	SYMBOL_NONE,                  // the empty name, used by literals
+	SYMBOL_FLOAT_STORAGE_VAR,     // %fsv
+	SYMBOL_FLOAT_RETURN_VAR,      // %frv
+	SYMBOL_LEFT_BOOL_VALUE,       // %lbv
+	SYMBOL_RIGHT_BOOL_VALUE,      // %rbv
+	SYMBOL_BUFFER_PARAMETERS_VAR, // %bpv
+	SYMBOL_ARRAY_INDEX_VAR,       // %aiv
+	SYMBOL_FLOAT_CALCULATION_VAR, // %fcv, the first calculation register
+	SYMBOL_CALCULATION_REGISTER_1,
+	SYMBOL_CALCULATION_REGISTER_2,
+	SYMBOL_CALCULATION_REGISTER_3,
+	SYMBOL_CALCULATION_REGISTER_4,
+	SYMBOL_CALCULATION_REGISTER_5,
+	SYMBOL_CALCULATION_REGISTER_6,
+	SYMBOL_CALCULATION_REGISTER_7,
+	SYMBOL_FIRST_USER_SYMBOL,     // every symbol before this one is used internally by the interpreter
+};
+
+// expressions are calculated in these registers, every stack frame has its own set so that a function call inside of an expression cannot overwrite them
+constexpr size_t CALCULATION_REGISTER_COUNT = SYMBOL_FIRST_USER_SYMBOL - SYMBOL_FLOAT_CALCULATION_VAR;
+
+namespace SymbolTable
+{
+	inline extern Symbol Intern(std::string_view name);
+	inline extern Symbol Find(std::string_view name); // returns SYMBOL_NONE if the name was never interned
+	inline extern const std::string& GetName(Symbol symbol);
+}
+
+inline bool IsInternalSymbol(Symbol symbol)
+{
+	return symbol != SYMBOL_NONE && symbol < SYMBOL_FIRST_USER_SYMBOL;
+}
+
+inline bool IsCalculationRegister(Symbol symbol)
+{
+	return symbol >= SYMBOL_FLOAT_CALCULATION_VAR && symbol < SYMBOL_FIRST_USER_SYMBOL;
+}
\ No newline at end of file
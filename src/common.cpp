@@ -1,4 +1,6 @@
 #include "common.hpp"
+#include "Array.hpp"
+#include "HashMap.hpp"
 
 inline bool DataTypeIsConstant(DataType type)
 {
@@ -17,23 +19,30 @@ void Variable::Create(VariableInfo info)
 	{
 	case DATA_TYPE_FLOAT_CONSTANT:
 	{
-		float resultF = std::stof(info.name);
+		float resultF = std::stof(info.literalValue);
 		memcpy(data.data(), &resultF, sizeof(resultF));
 		break;
 	}
 	case DATA_TYPE_CHAR_CONSTANT:
-		memcpy(data.data(), &info.name[0], sizeof(char));
+		memcpy(data.data(), &info.literalValue[0], sizeof(char));
 		break;
 	case DATA_TYPE_INT_CONSTANT:
 	{
-		int resultI = std::stof(info.name);
+		int resultI = std::stof(info.literalValue);
 		memcpy(data.data(), &resultI, sizeof(resultI));
 		break;
 	}
+	case DATA_TYPE_INT_ARRAY:
+	case DATA_TYPE_FLOAT_ARRAY:
+		array = std::make_shared<Array>(GetElementDataType(type)); // a declared array starts out empty
+		break;
+	case DATA_TYPE_MAP:
+		map = std::make_shared<HashMap>();
+		break;
 	default:
 		if (!DataTypeIsString(type))
 			break;
-		memcpy(data.data(), &info.name, size);
+		text = info.literalValue;
 		break;
 	}
 }
@@ -43,6 +52,19 @@ Variable::Variable(const Variable& rvalue) noexcept
 	type = rvalue.type;
 	size = rvalue.size;
 	data = rvalue.data;
+	text = rvalue.text;
+	array = rvalue.array;
+	map = rvalue.map;
+}
+
+Variable::Variable(Variable&& rvalue) noexcept
+{
+	type = rvalue.type;
+	size = rvalue.size;
+	data = std::move(rvalue.data);
+	text = std::move(rvalue.text);
+	array = std::move(rvalue.array);
+	map = std::move(rvalue.map);
 }
 
 Variable::Variable(const VariableInfo& info)
@@ -78,16 +100,21 @@ Variable::Variable(std::string rvalue)
 {
 	size = sizeof(rvalue);
 	type = DATA_TYPE_STRING;
-	data.resize(size);
-	memcpy(data.data(), &rvalue, size);
+	text = std::move(rvalue);
 }
 
-Variable::Variable(std::string value, std::string name)
+Variable::Variable(std::shared_ptr<Array> array)
 {
-	type = name == "" ? DATA_TYPE_STRING_CONSTANT : DATA_TYPE_STRING;
+	size = sizeof(array);
+	type = GetArrayDataType(array->elementType);
+	this->array = std::move(array);
+}
+
+Variable::Variable(std::string value, Symbol name)
+{
+	type = name == SYMBOL_NONE ? DATA_TYPE_STRING_CONSTANT : DATA_TYPE_STRING;
 	size = sizeof(value);
-	data.resize(size);
-	memcpy(data.data(), &value, size);
+	text = std::move(value);
 	this->name = name;
 }
 
@@ -136,23 +163,20 @@ Variable& Variable::operator=(uint64_t value)
 Variable& Variable::operator=(std::string rvalue)
 {
 	if (size == 0)
-	{
 		size = sizeof(std::string);
-		data.resize(size);
-	}
-	memcpy(data.data(), &rvalue, size);
+	text = std::move(rvalue);
 	return *this;
 }
 
 Variable& Variable::operator+=(const Variable& rvalue)
 {
-	if (type == DATA_TYPE_VOID && name[0] != '%')
+	if (type == DATA_TYPE_VOID && !IsInternalSymbol(name))
 		type = DATA_TYPE_INT; // assume int as the default type
 	switch (rvalue.type)
 	{
 	case DATA_TYPE_STRING_CONSTANT:
 	case DATA_TYPE_STRING:
-		*(std::string*)data.data() += (std::string)rvalue;
+		text += rvalue.text;
 		break;
 	
 	case DATA_TYPE_INT:
@@ -263,16 +287,66 @@ Variable operator*(Variable lvalue, const Variable& rvalue)
 	return lvalue;
 }
 
-std::string Variable::operator[](size_t index)
+Variable Variable::GetElement(int index) const
 {
-	if (type != DATA_TYPE_STRING && type != DATA_TYPE_STRING_CONSTANT)
-		throw std::runtime_error("Cannot index this type: only strings can be indexed");
-	std::string* ptr = (std::string*)data.data();
-	return std::string{ ptr->at(index) };
+	if (index < 0 || (size_t)index >= GetElementCount())
+		throw std::runtime_error("Index " + std::to_string(index) + " is out of range, the " + DataTypeToInternalTypeString(type) + " has " + std::to_string(GetElementCount()) + " elements");
+	switch (type)
+	{
+	case DATA_TYPE_INT_ARRAY:
+		return array->ints[index];
+	case DATA_TYPE_FLOAT_ARRAY:
+		return array->floats[index];
+	}
+	return std::string{ text[index] };
+}
+
+Variable Variable::GetElement(const Variable& index) const
+{
+	if (type != DATA_TYPE_MAP)
+		return GetElement((int)index);
+	const Variable* value = map->Find(index);
+	if (value == nullptr)
+		throw std::runtime_error("Key " + Variable(index).AsString() + " is not in the map");
+	return *value;
+}
+
+void Variable::SetElement(int index, const Variable& value)
+{
+	if (!DataTypeIsArray(type))
+		throw std::runtime_error("Cannot store an element in a " + DataTypeToInternalTypeString(type) + ": only arrays can be stored to");
+	if (index < 0 || (size_t)index >= GetElementCount())
+		throw std::runtime_error("Index " + std::to_string(index) + " is out of range, the " + DataTypeToInternalTypeString(type) + " has " + std::to_string(GetElementCount()) + " elements");
+	if (type == DATA_TYPE_INT_ARRAY)
+		array->ints[index] = (int)value;
+	else
+		array->floats[index] = (float)value;
+}
+
+void Variable::SetElement(const Variable& index, const Variable& value)
+{
+	if (type != DATA_TYPE_MAP)
+		return SetElement((int)index, value);
+	Variable& element = map->FindOrInsert(index);
+	element = value;
+	element.name = SYMBOL_NONE;
+}
+
+size_t Variable::GetElementCount() const
+{
+	if (DataTypeIsArray(type))
+		return array->Size();
+	if (DataTypeIsString(type))
+		return text.size();
+	if (type == DATA_TYPE_MAP)
+		return map->Size();
+	throw std::runtime_error("Cannot index a " + DataTypeToInternalTypeString(type) + ": only arrays and strings can be indexed");
 }
 
 bool operator<(const Variable& lvalue, const Variable& rvalue)
 {
+	if (DataTypeIsString(lvalue.type) && DataTypeIsString(rvalue.type))
+		return lvalue.text < rvalue.text;
 	return lvalue.data < rvalue.data;
 }
 
@@ -298,7 +372,7 @@ bool operator==(const Variable& lvalue, const Variable& rvalue)
 	{
 	case DATA_TYPE_STRING:
 	case DATA_TYPE_STRING_CONSTANT:
-		return *(std::string*)lvalue.data.data() == rvalue.GetDataAs<std::string>();
+		return lvalue.text == rvalue.GetDataAs<std::string>();
 	case DATA_TYPE_INT:
 	case DATA_TYPE_INT_CONSTANT:
 		return *(int*)lvalue.data.data() == rvalue.GetDataAs<int>();
@@ -308,6 +382,11 @@ bool operator==(const Variable& lvalue, const Variable& rvalue)
 	case DATA_TYPE_CHAR:
 	case DATA_TYPE_CHAR_CONSTANT:
 		return *(char*)lvalue.data.data() == rvalue.GetDataAs<char>();
+	case DATA_TYPE_INT_ARRAY:
+	case DATA_TYPE_FLOAT_ARRAY:
+		return lvalue.array == rvalue.array; // arrays are only equal to themselves
+	case DATA_TYPE_MAP:
+		return lvalue.map == rvalue.map;
 	}
 }
 
@@ -401,7 +480,7 @@ Variable::operator uint64_t() const
 Variable::operator std::string() const
 {
 	if (DataTypeIsString(type) || type == DATA_TYPE_VOID)
-		return *(std::string*)data.data();
+		return text;
 	return "";
 }
 
@@ -410,27 +489,60 @@ std::string Variable::AsString()
 	switch (type)
 	{
 	case DATA_TYPE_CHAR:
+	case DATA_TYPE_CHAR_CONSTANT:
 		return std::string{ (char)data[0] };
 	case DATA_TYPE_FLOAT:
+	case DATA_TYPE_FLOAT_CONSTANT:
 		return std::to_string(*(float*)data.data());
 	case DATA_TYPE_INT:
+	case DATA_TYPE_INT_CONSTANT:
 		return std::to_string(*(int*)data.data());
 	case DATA_TYPE_UINT64:
 		return std::to_string(*(uint64_t*)data.data());
 	case DATA_TYPE_VOID:
-		if (data.size() < sizeof(std::string))
+		if (size < sizeof(std::string))
 			break;
 		[[fallthrough]];
 	case DATA_TYPE_STRING:
-	case DATA_TYPE_CHAR_CONSTANT:
-	case DATA_TYPE_FLOAT_CONSTANT:
-	case DATA_TYPE_INT_CONSTANT:
 	case DATA_TYPE_STRING_CONSTANT:
-		return *(std::string*)data.data();
+		return text;
+	case DATA_TYPE_INT_ARRAY:
+	case DATA_TYPE_FLOAT_ARRAY:
+	{
+		std::string ret = "[";
+		for (size_t i = 0; i < array->Size(); i++)
+			ret += (i == 0 ? "" : ", ") + GetElement((int)i).AsString();
+		return ret + "]";
+	}
+	case DATA_TYPE_MAP:
+	{
+		std::string ret = "{";
+		for (size_t i = 0; i < map->Size(); i++)
+		{
+			HashMap::Entry entry = map->GetEntry(i);
+			ret += (i == 0 ? "" : ", ") + entry.key.AsString() + ": " + entry.value.AsString();
+		}
+		return ret + "}";
+	}
 	}
 	return "Cannot convert variable to string";
 }
 
+std::string_view Variable::GetStringView() const
+{
+	return text; // only strings have a text, every other type returns an empty view
+}
+
+Array* Variable::GetArray() const
+{
+	return DataTypeIsArray(type) ? array.get() : nullptr;
+}
+
+HashMap* Variable::GetMap() const
+{
+	return type == DATA_TYPE_MAP ? map.get() : nullptr;
+}
+
 DataType Variable::GetDataType()
 {
 	return type;
@@ -461,6 +573,34 @@ bool DataTypeIsString(DataType type)
 	return type == DATA_TYPE_STRING || type == DATA_TYPE_STRING_CONSTANT;
 }
 
+bool DataTypeIsArray(DataType type)
+{
+	return type == DATA_TYPE_INT_ARRAY || type == DATA_TYPE_FLOAT_ARRAY;
+}
+
+DataType GetArrayDataType(DataType elementType)
+{
+	switch (elementType)
+	{
+	case DATA_TYPE_INT:   return DATA_TYPE_INT_ARRAY;
+	case DATA_TYPE_FLOAT: return DATA_TYPE_FLOAT_ARRAY;
+	}
+	return DATA_TYPE_INVALID;
+}
+
+DataType GetElementDataType(DataType arrayType)
+{
+	switch (arrayType)
+	{
+	case DATA_TYPE_INT_ARRAY:       return DATA_TYPE_INT;
+	case DATA_TYPE_FLOAT_ARRAY:     return DATA_TYPE_FLOAT;
+	case DATA_TYPE_STRING:
+	case DATA_TYPE_STRING_CONSTANT: return DATA_TYPE_STRING;
+	case DATA_TYPE_MAP:             return DATA_TYPE_VOID;
+	}
+	return DATA_TYPE_INVALID;
+}
+
 size_t Sizeof(DataType dataType)
 {
 	switch (dataType)
@@ -474,13 +614,16 @@ size_t Sizeof(DataType dataType)
 	case DATA_TYPE_UINT64: return sizeof(uint64_t);
 	case DATA_TYPE_STRING_CONSTANT:
 	case DATA_TYPE_STRING: return sizeof(std::string);
+	case DATA_TYPE_INT_ARRAY:
+	case DATA_TYPE_FLOAT_ARRAY: return sizeof(std::shared_ptr<Array>);
+	case DATA_TYPE_MAP: return sizeof(std::shared_ptr<HashMap>);
 	}
 	return 0;
 }
 
 bool operator==(const VariableInfo& lvalue, const VariableInfo& rvalue)
 {
-	if (lvalue.name == "" && rvalue.name == "")
+	if (lvalue.name == SYMBOL_NONE && rvalue.name == SYMBOL_NONE)
 		return lvalue.literalValue == rvalue.literalValue && lvalue.dataType == rvalue.dataType;
 	return lvalue.name == rvalue.name && lvalue.dataType == rvalue.dataType;
 }
@@ -513,6 +656,9 @@ std::string InstructionTypeToString(InstructionType type)
 	case INSTRUCTION_TYPE_INDEX:             return "INSTRUCTION_TYPE_INDEX";
 	case INSTRUCTION_TYPE_DEREFERENCE:       return "INSTRUCTION_TYPE_DEREFERENCE";
 	case INSTRUCTION_TYPE_ASSIGN_LOCATION:   return "INSTRUCTION_TYPE_ASSIGN_LOCATION";
+	case INSTRUCTION_TYPE_STORE_INDEX:       return "INSTRUCTION_TYPE_STORE_INDEX";
+	case INSTRUCTION_TYPE_PARALLEL_FOR:      return "INSTRUCTION_TYPE_PARALLEL_FOR";
+	case INSTRUCTION_TYPE_YIELD:             return "INSTRUCTION_TYPE_YIELD";
 	}
 	return "";
 }
@@ -528,10 +674,13 @@ std::string DataTypeToInternalTypeString(DataType type)
 	case DATA_TYPE_VOID:            return "void";
 	case DATA_TYPE_USERTYPE:        return "user_type";
 	case DATA_TYPE_UINT64:          return "uint64";
+	case DATA_TYPE_MAP:             return "map";
 	case DATA_TYPE_FLOAT_CONSTANT:  return "float_literal";
 	case DATA_TYPE_CHAR_CONSTANT:   return "char_literal";
 	case DATA_TYPE_INT_CONSTANT:    return "int_literal";
 	case DATA_TYPE_STRING_CONSTANT: return "string_literal";
+	case DATA_TYPE_INT_ARRAY:       return "int[]";
+	case DATA_TYPE_FLOAT_ARRAY:     return "float[]";
 	}
 	return "invalid_type";
 }
@@ -546,11 +695,14 @@ std::string DataTypeToString(DataType type)
 	case DATA_TYPE_INT:             return "DATA_TYPE_INT";
 	case DATA_TYPE_STRING:          return "DATA_TYPE_STRING";
 	case DATA_TYPE_VOID:            return "DATA_TYPE_VOID";
+	case DATA_TYPE_MAP:             return "DATA_TYPE_MAP";
 	case DATA_TYPE_USERTYPE:        return "DATA_TYPE_USERTYPE";
 	case DATA_TYPE_FLOAT_CONSTANT:  return "DATA_TYPE_FLOAT_CONSTANT";
 	case DATA_TYPE_CHAR_CONSTANT:   return "DATA_TYPE_CHAR_CONSTANT";
 	case DATA_TYPE_INT_CONSTANT:    return "DATA_TYPE_INT_CONSTANT";
 	case DATA_TYPE_STRING_CONSTANT: return "DATA_TYPE_STRING_CONSTANT";
+	case DATA_TYPE_INT_ARRAY:       return "DATA_TYPE_INT_ARRAY";
+	case DATA_TYPE_FLOAT_ARRAY:     return "DATA_TYPE_FLOAT_ARRAY";
 	}
 	return "";
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include <type_traits>
+#include <memory>
 #include <stdexcept>
+#include "Symbol.hpp"
 
 typedef unsigned char byte;
 
@@ -29,9 +32,12 @@ enum InstructionType
 	INSTRUCTION_TYPE_JUMP, // jump is relative to the current instruction index
 	INSTRUCTION_TYPE_PUSH_SCOPE,
 	INSTRUCTION_TYPE_POP_SCOPE,
-	INSTRUCTION_TYPE_INDEX,
+	INSTRUCTION_TYPE_INDEX, // replaces the array, string or map in the first operand with its element at the second operand
 	INSTRUCTION_TYPE_DEREFERENCE,
-	INSTRUCTION_TYPE_ASSIGN_LOCATION
+	INSTRUCTION_TYPE_ASSIGN_LOCATION,
+	INSTRUCTION_TYPE_STORE_INDEX, // stores the second operand in the array or map of the first operand, at the index or key in %aiv
+	INSTRUCTION_TYPE_PARALLEL_FOR, // runs the body that the following jump skips for every value of the first operand up to the second operand, spread over all cores
+	INSTRUCTION_TYPE_YIELD, // suspends a generator with the value in %frv, it continues at the next instruction when the next value is asked for
 };
 inline extern std::string InstructionTypeToString(InstructionType type);
 
@@ -44,12 +50,15 @@ enum DataType
 	DATA_TYPE_STRING,
 	DATA_TYPE_VOID,
 	DATA_TYPE_UINT64,
+	DATA_TYPE_MAP, // every type up to here has a keyword, their lexemes have the same values
 	DATA_TYPE_USERTYPE,
 	DATA_TYPE_FLOAT_CONSTANT,
 	DATA_TYPE_CHAR_CONSTANT,
 	DATA_TYPE_INT_CONSTANT,
 	DATA_TYPE_STRING_CONSTANT,
 	DATA_TYPE_POINTER,
+	DATA_TYPE_INT_ARRAY,
+	DATA_TYPE_FLOAT_ARRAY,
 };
 inline extern std::string DataTypeToInternalTypeString(DataType type);
 inline extern std::string DataTypeToString(DataType type);
@@ -57,6 +66,9 @@ inline extern bool DataTypeIsFloat(DataType type);
 inline extern bool DataTypeIsChar(DataType type);
 inline extern bool DataTypeIsInt(DataType type);
 inline extern bool DataTypeIsString(DataType type);
+inline extern bool DataTypeIsArray(DataType type);
+inline extern DataType GetArrayDataType(DataType elementType); // returns DATA_TYPE_INVALID if there are no arrays of the type
+inline extern DataType GetElementDataType(DataType arrayType); // the element of a string is a string with one char, the values of a map are only known at runtime (void)
 
 inline extern size_t Sizeof(DataType dataType);
 
@@ -75,9 +87,12 @@ template<typename T> inline DataType GetDataTypeTemplate()
 	return DATA_TYPE_INVALID;
 }
 
+struct Array;
+class HashMap;
+
 struct VariableInfo
 {
-	std::string name = "";
+	Symbol name = SYMBOL_NONE;
 	DataType dataType = DATA_TYPE_INVALID;
 	uint32_t size = 0;
 	std::string literalValue;
@@ -88,20 +103,26 @@ struct VariableInfo
 struct Variable
 {
 	Variable() = default;
-	Variable(const Variable& rvalue) noexcept;
+	Variable(const Variable& rvalue) noexcept; // the name and the base type are not copied
+	Variable(Variable&& rvalue) noexcept;      // the same as the copy, but the value is moved
 	Variable(const VariableInfo& rvalue);
-	Variable(std::string value, std::string name);
+	Variable(std::string value, Symbol name);
 	Variable(float rvalue);
 	Variable(char rvalue);
 	Variable(int rvalue);
 	Variable(std::string rvalue);
+	Variable(std::shared_ptr<Array> array);
 
 	Variable& operator+=(const Variable& rvalue);
 	Variable& operator-=(const Variable& rvalue);
 	Variable& operator*=(const Variable& rvalue);
 	Variable& operator/=(const Variable& rvalue);
 
-	std::string operator[](size_t index);
+	Variable GetElement(int index) const; // only for arrays and strings
+	Variable GetElement(const Variable& index) const; // maps are indexed by their keys, everything else by an int
+	void SetElement(int index, const Variable& value); // only for arrays
+	void SetElement(const Variable& index, const Variable& value); // a map gets a new entry if it does not have the key yet
+	size_t GetElementCount() const;
 
 	extern friend Variable operator+(Variable lvalue, const Variable& rvalue);
 	extern friend Variable operator-(Variable lvalue, const Variable& rvalue);
@@ -122,17 +143,22 @@ struct Variable
 	operator uint64_t() const;
 	operator std::string() const;
 
+	Variable& operator=(const Variable& rvalue) = default; // unlike the constructors, assigning takes over the name as well
+	Variable& operator=(Variable&& rvalue) noexcept = default;
 	Variable& operator=(float rvalue);
 	Variable& operator=(char rvalue);
 	Variable& operator=(int rvalue);
 	Variable& operator=(uint64_t value);
 	Variable& operator=(std::string rvalue);
 	
-	std::string name = "";
+	Symbol name = SYMBOL_NONE;
 	DataType type = DATA_TYPE_INVALID;
 	DataType baseType = DATA_TYPE_INVALID; // only applies if the variable is a pointer
 
 	std::string AsString();
+	std::string_view GetStringView() const; // refers to the value of the variable, so it is only valid as long as the variable does not change
+	Array* GetArray() const; // nullptr if the variable is not an array
+	HashMap* GetMap() const; // nullptr if the variable is not a map
 	DataType GetDataType();
 	void SetDataType(DataType type);
 
@@ -141,12 +167,18 @@ private:
 	{
 		if (type != GetDataTypeTemplate<T>() || size != sizeof(T))
 			throw std::runtime_error("Invalid cast: types do not match");
-		return *(T*)data.data();
+		if constexpr (std::is_same_v<T, std::string>)
+			return text;
+		else
+			return *(T*)data.data();
 	}
 	void Create(VariableInfo info);
 
 	size_t size = 0;
 	std::vector<uint8_t> data;
+	std::string text; // the value of a string, it cannot be kept in data because a std::string is not trivially copyable
+	std::shared_ptr<Array> array; // variables that are assigned to each other share the same array
+	std::shared_ptr<HashMap> map; // shared the same way as an array
 };
 
 struct Instruction
@@ -160,4 +192,14 @@ struct Instruction
 inline bool IsInstructionSelfAssigning(Instruction& instruction)
 {
 	return (instruction.type == INSTRUCTION_TYPE_ASSIGN) && (instruction.operand1.name == instruction.operand2.name);
+}
+
+inline uint64_t HashContent(std::string_view content, uint64_t hash = 14695981039346656037ull) // FNV-1a, it is only used to notice that something changed
+{
+	for (char character : content)
+	{
+		hash ^= (unsigned char)character;
+		hash *= 1099511628211ull;
+	}
+	return hash;
 }
\ No newline at end of file
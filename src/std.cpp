@@ -1,149 +1,903 @@
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <charconv>
+#include <cmath>
+#include <unordered_map>
 #include "std.hpp"
 #include "Interpreter.hpp"
 #include "Parser.hpp"
+#include "FileIO.hpp"
+#include "Array.hpp"
+#include "SIMD.hpp"
+#include "HashMap.hpp"
+#include "Parallel.hpp"
+#include "Generator.hpp"
+#include "Channel.hpp"
+#include "ScriptContext.hpp"
 
-#define SET_EXTERN_FUNCTION(name) if (Parser::DoesFunctionExist(#name)) Interpreter::SetExternFunction<##name##>(#name);
+inline size_t FindInString(std::string_view text, std::string_view pattern, size_t from = 0) // memchr finds the candidates for the first char, which is a lot faster than comparing at every position
+{
+	if (pattern.empty())
+		return from <= text.size() ? from : std::string_view::npos;
+
+	while (from + pattern.size() <= text.size())
+	{
+		const char* candidate = (const char*)memchr(text.data() + from, pattern[0], text.size() - pattern.size() + 1 - from);
+		if (candidate == nullptr)
+			break;
+		from = candidate - text.data();
+		if (memcmp(candidate + 1, pattern.data() + 1, pattern.size() - 1) == 0)
+			return from;
+		from++;
+	}
+	return std::string_view::npos;
+}
 
-void StandardLib::Init()
+inline std::string_view GetStringPart(std::string_view text, std::string_view separator, int index) // returns an empty part if there are not enough parts
 {
-	for (std::string file : importedFiles)
+	size_t begin = 0;
+	for (; index > 0; index--)
 	{
-		if (file == "std/io.script")
-		{
-			SET_EXTERN_FUNCTION(WriteLine);
-			SET_EXTERN_FUNCTION(GetLine);
-		}
-		if (file == "std/types.script")
-		{
-			SET_EXTERN_FUNCTION(ToString);
-			SET_EXTERN_FUNCTION(ToFloat);
-			SET_EXTERN_FUNCTION(ToInt);
-			SET_EXTERN_FUNCTION(ToString);
-			SET_EXTERN_FUNCTION(IntToString);
-		}
-		if (file == "std/string.script")
-		{
-			SET_EXTERN_FUNCTION(IndexString);
-		}
-		if (file == "std/reflection.script")
-		{
-			SET_EXTERN_FUNCTION(nameof);
-			SET_EXTERN_FUNCTION(typeof);
-		}
+		size_t end = FindInString(text, separator, begin);
+		if (end == std::string_view::npos || separator.empty())
+			return {};
+		begin = end + separator.size();
+	}
+	return text.substr(begin, FindInString(text, separator, begin) - begin);
+}
+
+inline std::string_view TrimSpaces(std::string_view text)
+{
+	size_t begin = text.find_first_not_of(" \t\r\n");
+	if (begin == std::string_view::npos)
+		return {};
+	return text.substr(begin, text.find_last_not_of(" \t\r\n") - begin + 1);
+}
+
+template<typename T> inline T ParseNumber(std::string_view text, const char* function) // unlike std::stoi, the whole text has to be the number
+{
+	text = TrimSpaces(text);
+	std::string_view number = !text.empty() && text[0] == '+' ? text.substr(1) : text; // from_chars does not accept a plus sign
+	T ret{};
+	auto [end, error] = std::from_chars(number.data(), number.data() + number.size(), ret);
+	if (error != std::errc() || end != number.data() + number.size() || number.empty())
+		throw std::runtime_error(std::string(function) + ": \"" + std::string(text) + "\" is not a valid number");
+	return ret;
+}
+
+template<typename T> inline std::string FormatNumber(T value) // the shortest text that parses back to the same value
+{
+	char buffer[64];
+	return std::string(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+}
+
+template<typename T, typename F> inline void ParseNumbers(std::string_view text, std::string_view separator, const char* function, F onNumber) // parts that only contain spaces are skipped, so "1, 2, 3\n" has 3 numbers
+{
+	size_t begin = 0;
+	while (begin <= text.size())
+	{
+		size_t end = separator.empty() ? std::string_view::npos : FindInString(text, separator, begin);
+		std::string_view part = text.substr(begin, end - begin);
+		if (!TrimSpaces(part).empty())
+			onNumber(ParseNumber<T>(part, function));
+		if (end == std::string_view::npos)
+			break;
+		begin = end + separator.size();
+	}
+}
+
+template<typename T> inline T SumNumbers(std::string_view text, std::string_view separator, const char* function)
+{
+	T ret{};
+	ParseNumbers<T>(text, separator, function, [&](T number) { ret += number; });
+	return ret;
+}
+
+template<typename T> inline std::string FormatNumbers(const AlignedVector<T>& values, std::string_view separator) // written straight into one string, without a string per number
+{
+	std::string ret;
+	ret.reserve(values.size() * (12 + separator.size()));
+	char buffer[64];
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		if (i > 0)
+			ret.append(separator);
+		ret.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), values[i]).ptr);
+	}
+	return ret;
+}
+
+inline void WriteLine(ScriptContext& context, std::string_view text)
+{
+	context.output.Write(text);
+	context.output.Write("\n");
+}
+
+inline void Write(ScriptContext& context, std::string_view text)
+{
+	context.output.Write(text);
+}
+
+inline void Flush(ScriptContext& context)
+{
+	context.output.Flush();
+}
+
+inline std::string GetLine(ScriptContext& context)
+{
+	return context.input.ReadLine();
+}
+
+inline std::string ReadAll(ScriptContext& context)
+{
+	return context.input.ReadAll();
+}
+
+inline bool IsEndOfInput(ScriptContext& context)
+{
+	return context.input.IsAtEnd();
+}
+
+inline int OpenFile(ScriptContext& context, std::string path)
+{
+	return FileIO::OpenForReading(context, path);
+}
+
+inline int CreateFileForWriting(ScriptContext& context, std::string path) // not called CreateFile, which is a macro in Windows.h
+{
+	return FileIO::OpenForWriting(context, path);
+}
+
+inline std::string ReadFileLine(ScriptContext& context, int file)
+{
+	return FileIO::ReadLine(context, file);
+}
+
+inline std::string ReadFileChunk(ScriptContext& context, int file, int size)
+{
+	if (size < 0)
+		throw std::runtime_error("ReadFileChunk: the size " + std::to_string(size) + " is negative");
+	return FileIO::ReadChunk(context, file, size);
+}
+
+inline bool IsEndOfFile(ScriptContext& context, int file)
+{
+	return FileIO::IsAtEnd(context, file);
+}
+
+inline void WriteFile(ScriptContext& context, int file, std::string_view text)
+{
+	FileIO::Write(context, file, text);
+}
+
+inline void CloseFile(ScriptContext& context, int file)
+{
+	FileIO::Close(context, file);
+}
+
+inline std::string ToString(float value)
+{
+	return FormatNumber(value);
+}
+
+inline std::string IntToString(int value)
+{
+	return FormatNumber(value);
+}
+
+inline float ToFloat(std::string_view text)
+{
+	return ParseNumber<float>(text, "ToFloat");
+}
+
+inline int ToInt(std::string_view text)
+{
+	return ParseNumber<int>(text, "ToInt");
+}
+
+inline int SumInts(std::string_view text, std::string_view separator)
+{
+	return SumNumbers<int>(text, separator, "SumInts");
+}
+
+inline float SumFloats(std::string_view text, std::string_view separator)
+{
+	return SumNumbers<float>(text, separator, "SumFloats");
+}
+
+inline int ToIntAt(std::string_view text, std::string_view separator, int index)
+{
+	if (index < 0)
+		throw std::runtime_error("ToIntAt: the index " + std::to_string(index) + " is negative");
+	return ParseNumber<int>(GetStringPart(text, separator, index), "ToIntAt");
+}
+
+inline float ToFloatAt(std::string_view text, std::string_view separator, int index)
+{
+	if (index < 0)
+		throw std::runtime_error("ToFloatAt: the index " + std::to_string(index) + " is negative");
+	return ParseNumber<float>(GetStringPart(text, separator, index), "ToFloatAt");
+}
+
+inline std::string IndexString(std::string_view input, int index)
+{
+	if (index < 0 || index >= (int)input.size())
+		throw std::runtime_error("IndexString: the index " + std::to_string(index) + " is outside of the string");
+	return std::string{ input[index] };
+}
+
+inline int Length(std::string_view text)
+{
+	return (int)text.size();
+}
+
+inline std::string Substring(std::string_view text, int begin, int length)
+{
+	if (begin < 0 || begin > (int)text.size() || length < 0)
+		throw std::runtime_error("Substring: the range starting at " + std::to_string(begin) + " with length " + std::to_string(length) + " is outside of the string");
+	return std::string(text.substr(begin, length)); // a length past the end stops at the end, like std::string::substr
+}
+
+inline int Find(std::string_view text, std::string_view pattern, int from)
+{
+	size_t index = from < 0 ? std::string_view::npos : FindInString(text, pattern, from);
+	return index == std::string_view::npos ? -1 : (int)index;
+}
+
+inline bool StartsWith(std::string_view text, std::string_view prefix)
+{
+	return text.substr(0, prefix.size()) == prefix;
+}
+
+inline std::string Replace(std::string_view text, std::string_view pattern, std::string_view replacement)
+{
+	if (pattern.empty())
+		return std::string(text);
+
+	std::vector<size_t> matches; // the matches are found first, so that the result can be allocated at its final size
+	for (size_t match = FindInString(text, pattern); match != std::string_view::npos; match = FindInString(text, pattern, match + pattern.size()))
+		matches.push_back(match);
+
+	std::string ret;
+	ret.reserve(text.size() + matches.size() * replacement.size() - matches.size() * pattern.size());
+	size_t copiedUntil = 0;
+	for (size_t match : matches)
+	{
+		ret.append(text, copiedUntil, match - copiedUntil);
+		ret.append(replacement);
+		copiedUntil = match + pattern.size();
 	}
+	ret.append(text.substr(copiedUntil));
+	return ret;
+}
+
+inline int SplitCount(std::string_view text, std::string_view separator)
+{
+	int count = 1;
+	for (size_t match = FindInString(text, separator); match != std::string_view::npos && !separator.empty(); match = FindInString(text, separator, match + separator.size()))
+		count++;
+	return count;
+}
+
+inline std::string SplitFrom(std::string_view text, std::string_view separator, int from) // only searches from the given offset, so walking through every part with Find stays linear
+{
+	if (from < 0 || from > (int)text.size())
+		throw std::runtime_error("SplitFrom: the offset " + std::to_string(from) + " is outside of the string");
+	size_t end = separator.empty() ? std::string_view::npos : FindInString(text, separator, from);
+	return std::string(text.substr(from, end == std::string_view::npos ? std::string_view::npos : end - from));
+}
+
+inline std::string NameOf(Variable& var)
+{
+	return SymbolTable::GetName(var.name); // the pulled parameter keeps the symbol of the variable that was pushed
+}
+
+inline std::string TypeOf(Variable& var)
+{
+	return DataTypeToInternalTypeString(var.type);
+}
+
+inline Array& GetArrayArgument(const Variable& var, const char* function)
+{
+	if (var.GetArray() == nullptr)
+		throw std::runtime_error(std::string(function) + ": expected an int[] or a float[], got a " + DataTypeToInternalTypeString(var.type));
+	return *var.GetArray();
+}
+
+inline Array& GetNonEmptyArrayArgument(const Variable& var, const char* function)
+{
+	Array& ret = GetArrayArgument(var, function);
+	if (ret.Size() == 0)
+		throw std::runtime_error(std::string(function) + ": the array is empty");
+	return ret;
+}
+
+inline Array& GetFloatArrayArgument(const Variable& var, const char* function) // for the functions that replace the elements in place, which an int[] cannot hold
+{
+	Array& ret = GetArrayArgument(var, function);
+	if (ret.elementType != DATA_TYPE_FLOAT)
+		throw std::runtime_error(std::string(function) + ": expected a float[], got an int[]");
+	return ret;
+}
+
+inline Array& GetIntArrayArgument(const Variable& var, const char* function)
+{
+	Array& ret = GetArrayArgument(var, function);
+	if (ret.elementType != DATA_TYPE_INT)
+		throw std::runtime_error(std::string(function) + ": expected an int[], got a float[]");
+	return ret;
+}
+
+inline void CheckSameArrays(const Array& left, const Array& right, const char* function)
+{
+	if (left.elementType != right.elementType || left.Size() != right.Size())
+		throw std::runtime_error(std::string(function) + ": both arrays need the same type and the same number of elements, got " + std::to_string(left.Size()) + " and " + std::to_string(right.Size()) + " elements");
+}
+
+inline Variable IntArray(int size)
+{
+	if (size < 0)
+		throw std::runtime_error("IntArray: the size " + std::to_string(size) + " is negative");
+	return Variable(std::make_shared<Array>(DATA_TYPE_INT, size));
+}
+
+inline Variable FloatArray(int size)
+{
+	if (size < 0)
+		throw std::runtime_error("FloatArray: the size " + std::to_string(size) + " is negative");
+	return Variable(std::make_shared<Array>(DATA_TYPE_FLOAT, size));
+}
+
+inline Variable ParseInts(std::string_view text, std::string_view separator)
+{
+	std::shared_ptr<Array> ret = std::make_shared<Array>(DATA_TYPE_INT);
+	ParseNumbers<int>(text, separator, "ParseInts", [&](int number) { ret->ints.push_back(number); });
+	return Variable(ret);
+}
+
+inline Variable ParseFloats(std::string_view text, std::string_view separator)
+{
+	std::shared_ptr<Array> ret = std::make_shared<Array>(DATA_TYPE_FLOAT);
+	ParseNumbers<float>(text, separator, "ParseFloats", [&](float number) { ret->floats.push_back(number); });
+	return Variable(ret);
+}
+
+inline std::string FormatInts(Variable& values, std::string_view separator)
+{
+	return FormatNumbers(GetIntArrayArgument(values, "FormatInts").ints, separator);
+}
+
+inline std::string FormatFloats(Variable& values, std::string_view separator)
+{
+	return FormatNumbers(GetFloatArrayArgument(values, "FormatFloats").floats, separator);
+}
+
+inline int Count(Variable& values)
+{
+	return (int)GetArrayArgument(values, "Count").Size();
+}
+
+inline Variable Sum(Variable& values)
+{
+	Array& array = GetArrayArgument(values, "Sum");
+	if (array.elementType == DATA_TYPE_INT)
+		return SIMD::Sum(array.ints.data(), array.ints.size());
+	return SIMD::Sum(array.floats.data(), array.floats.size());
 }
 
-WriteLine::WriteLine(Function* function) : Function(function)
+inline Variable Min(Variable& values)
 {
-	name = "WriteLine";
-	parameters = { { "text", DATA_TYPE_STRING } };
-	returnType = DATA_TYPE_VOID;
+	Array& array = GetNonEmptyArrayArgument(values, "Min");
+	if (array.elementType == DATA_TYPE_INT)
+		return SIMD::Min(array.ints.data(), array.ints.size());
+	return SIMD::Min(array.floats.data(), array.floats.size());
 }
 
-void WriteLine::Execute()
+inline Variable Max(Variable& values)
 {
-	std::cout << Interpreter::FindVariable("text")->AsString() << "\n";
-	Return({});
+	Array& array = GetNonEmptyArrayArgument(values, "Max");
+	if (array.elementType == DATA_TYPE_INT)
+		return SIMD::Max(array.ints.data(), array.ints.size());
+	return SIMD::Max(array.floats.data(), array.floats.size());
 }
 
-ToString::ToString(Function* function) : Function(function)
+inline Variable Dot(Variable& left, Variable& right)
 {
-	name = "ToString";
-	parameters = { { "value", DATA_TYPE_FLOAT } };
-	returnType = DATA_TYPE_STRING;
+	Array& leftArray = GetArrayArgument(left, "Dot");
+	Array& rightArray = GetArrayArgument(right, "Dot");
+	CheckSameArrays(leftArray, rightArray, "Dot");
+	if (leftArray.elementType == DATA_TYPE_INT)
+		return SIMD::Dot(leftArray.ints.data(), rightArray.ints.data(), leftArray.ints.size());
+	return SIMD::Dot(leftArray.floats.data(), rightArray.floats.data(), leftArray.floats.size());
 }
 
-void ToString::Execute()
+inline void Scale(Variable& values, float factor) // an int[] is scaled by the factor converted to an int
 {
-	Return({ {}, DATA_TYPE_STRING, sizeof(std::string), Interpreter::FindVariable("value")->AsString() });
+	Array& array = GetArrayArgument(values, "Scale");
+	if (array.elementType == DATA_TYPE_INT)
+		SIMD::Scale(array.ints.data(), (int)factor, array.ints.size());
+	else
+		SIMD::Scale(array.floats.data(), factor, array.floats.size());
 }
 
-IntToString::IntToString(Function* function) : Function(function)
+inline void Add(Variable& values, Variable& other)
 {
-	name = "IntToString";
-	parameters = { { "value", DATA_TYPE_INT } };
-	returnType = DATA_TYPE_STRING;
+	Array& array = GetArrayArgument(values, "Add");
+	Array& otherArray = GetArrayArgument(other, "Add");
+	CheckSameArrays(array, otherArray, "Add");
+	if (array.elementType == DATA_TYPE_INT)
+		SIMD::Add(array.ints.data(), otherArray.ints.data(), array.ints.size());
+	else
+		SIMD::Add(array.floats.data(), otherArray.floats.data(), array.floats.size());
 }
 
-void IntToString::Execute()
+inline float Abs(float value)
 {
-	Variable* var = Interpreter::FindVariable("value");
-	var->SetDataType(DATA_TYPE_INT);
-	Return({ {}, DATA_TYPE_STRING, sizeof(std::string), var->AsString() });
+	return std::abs(value);
 }
 
-ToFloat::ToFloat(Function* function) : Function(function)
+inline float Floor(float value)
 {
-	name = "ToFloat";
-	parameters = { { "text", DATA_TYPE_STRING } };
-	returnType = DATA_TYPE_FLOAT;
+	return std::floor(value);
 }
 
-void ToFloat::Execute()
+inline float Ceil(float value)
 {
-	Return({ {}, DATA_TYPE_FLOAT, sizeof(float), std::to_string(std::stof(*Interpreter::FindVariable("text"))) });
+	return std::ceil(value);
 }
 
-ToInt::ToInt(Function* function) : Function(function)
+inline float Round(float value) // halfway values are rounded away from zero
 {
-	name = "ToInt";
-	parameters = { { "text", DATA_TYPE_STRING } };
-	returnType = DATA_TYPE_INT;
+	return std::round(value);
 }
 
-void ToInt::Execute()
+inline float Sqrt(float value)
 {
-	std::string str = (std::string)*Interpreter::FindVariable("text");
-	int var = std::stoi(str);
-	std::string ret = std::to_string(var);
-	Return({ {}, DATA_TYPE_INT, sizeof(int), ret });
+	return std::sqrt(value);
 }
 
-nameof::nameof(Function* function) : Function(function)
+inline float Pow(float base, float exponent)
 {
-	name = "nameof";
-	parameters = { { "var", DATA_TYPE_VOID } };
-	returnType = DATA_TYPE_STRING;
+	return std::pow(base, exponent);
 }
 
-void nameof::Execute()
+inline float Exp(float value)
 {
-	Return({ stackFrame["var"].name, DATA_TYPE_STRING_CONSTANT });
+	return std::exp(value);
 }
 
-typeof::typeof(Function* function) : Function(function)
+inline float Log(float value)
 {
-	name = "typeof";
-	parameters = { { "var", DATA_TYPE_VOID } };
-	returnType = DATA_TYPE_STRING;
+	return std::log(value);
 }
 
-void typeof::Execute()
+inline float Sin(float value)
 {
-	Return({ DataTypeToInternalTypeString(Interpreter::FindVariable("var")->type), DATA_TYPE_STRING_CONSTANT });
+	return std::sin(value);
 }
 
-GetLine::GetLine(Function* function) : Function(function)
+inline float Cos(float value)
 {
-	name = "GetLine";
-	returnType = DATA_TYPE_STRING_CONSTANT;
+	return std::cos(value);
 }
 
-void GetLine::Execute()
+inline float Tan(float value)
 {
+	return std::tan(value);
+}
+
+inline float Atan2(float y, float x)
+{
+	return std::atan2(y, x);
+}
+
+inline void SqrtAll(Variable& values)
+{
+	Array& array = GetFloatArrayArgument(values, "SqrtAll");
+	SIMD::Sqrt(array.floats.data(), array.floats.size());
+}
+
+inline void ExpAll(Variable& values) // there is no SIMD instruction for exp, but compilers vectorize this loop with their vector math library
+{
+	Array& array = GetFloatArrayArgument(values, "ExpAll");
+	for (float& value : array.floats)
+		value = std::exp(value);
+}
+
+inline float Mean(Variable& values)
+{
+	Array& array = GetNonEmptyArrayArgument(values, "Mean");
+	if (array.elementType == DATA_TYPE_FLOAT)
+		return SIMD::Sum(array.floats.data(), array.floats.size()) / array.floats.size();
+
+	int64_t sum = 0; // the sum of an int[] can overflow an int
+	for (int value : array.ints)
+		sum += value;
+	return (float)((double)sum / array.ints.size());
+}
+
+inline float Variance(Variable& values) // of the whole population, so divided by the number of elements
+{
+	Array& array = GetNonEmptyArrayArgument(values, "Variance");
+	float mean = Mean(values);
+	if (array.elementType == DATA_TYPE_FLOAT)
+		return SIMD::SquaredDeviationSum(array.floats.data(), array.floats.size(), mean) / array.floats.size();
+
+	double sum = 0;
+	for (int value : array.ints)
+		sum += ((double)value - mean) * ((double)value - mean);
+	return (float)(sum / array.ints.size());
+}
+
+constexpr size_t PARALLEL_SORT_THRESHOLD = 1 << 16; // the number of elements per thread below which starting the threads takes longer than sorting
+
+template<typename T> inline bool IsSortedBefore(T left, T right) // NaNs are sorted to the end, otherwise floats would not have a strict weak ordering
+{
+	if constexpr (std::is_floating_point_v<T>)
+		return left < right || (right != right && left == left);
+	else
+		return left < right;
+}
+
+template<typename T> inline void SortValues(T* values, size_t count) // every thread sorts a chunk of its own, then neighbouring chunks are merged until one is left
+{
+	size_t chunkCount = std::min((size_t)std::thread::hardware_concurrency(), count / PARALLEL_SORT_THRESHOLD);
+	if (chunkCount < 2)
+	{
+		std::sort(values, values + count, IsSortedBefore<T>);
+		return;
+	}
+
+	std::vector<size_t> bounds(chunkCount + 1);
+	for (size_t i = 0; i <= chunkCount; i++)
+		bounds[i] = count * i / chunkCount;
+	Parallel::For(chunkCount, [&](size_t i)
+	{
+		std::sort(values + bounds[i], values + bounds[i + 1], IsSortedBefore<T>);
+	});
+	for (size_t width = 1; width < chunkCount; width *= 2)
+	{
+		Parallel::For((chunkCount + width * 2 - 1) / (width * 2), [&](size_t i)
+		{
+			size_t first = i * width * 2, middle = std::min(first + width, chunkCount), last = std::min(first + width * 2, chunkCount);
+			std::inplace_merge(values + bounds[first], values + bounds[middle], values + bounds[last], IsSortedBefore<T>);
+		});
+	}
+}
+
+template<typename T> inline int SearchSortedValues(const AlignedVector<T>& values, T value)
+{
+	auto found = std::lower_bound(values.begin(), values.end(), value, IsSortedBefore<T>);
+	return found != values.end() && !IsSortedBefore(value, *found) ? (int)(found - values.begin()) : -1;
+}
+
+inline std::vector<std::string_view> SplitParts(std::string_view text, std::string_view separator)
+{
+	std::vector<std::string_view> ret;
+	size_t begin = 0;
+	for (size_t end = FindInString(text, separator); end != std::string_view::npos && !separator.empty(); end = FindInString(text, separator, begin))
+	{
+		ret.push_back(text.substr(begin, end - begin));
+		begin = end + separator.size();
+	}
+	ret.push_back(text.substr(begin));
+	return ret;
+}
+
+inline std::string JoinParts(const std::vector<std::string_view>& parts, std::string_view separator)
+{
+	size_t size = parts.size() * separator.size();
+	for (std::string_view part : parts)
+		size += part.size();
+
 	std::string ret;
-	std::cin >> ret;
-	Return({ {}, DATA_TYPE_STRING, sizeof(std::string), ret});
+	ret.reserve(size);
+	for (size_t i = 0; i < parts.size(); i++)
+		ret.append(i == 0 ? "" : separator).append(parts[i]);
+	return ret;
+}
+
+inline void Sort(Variable& values)
+{
+	Array& array = GetArrayArgument(values, "Sort");
+	if (array.elementType == DATA_TYPE_INT)
+		SortValues(array.ints.data(), array.ints.size());
+	else
+		SortValues(array.floats.data(), array.floats.size());
+}
+
+inline void SortBy(ScriptContext& context, Variable& values, std::string_view comparator) // the comparator runs in the interpreter, so this sort cannot use other threads
+{
+	Array& array = GetArrayArgument(values, "SortBy");
+	if (!Parser::DoesFunctionExist(context, comparator))
+		throw std::runtime_error("SortBy: there is no function called " + std::string(comparator));
+
+	Symbol function = SymbolTable::Find(comparator);
+	Interpreter& interpreter = context.GetInterpreter();
+	auto IsBefore = [&interpreter, function](auto left, auto right)
+	{
+		return (int)interpreter.CallFunction(function, { Variable(left), Variable(right) }) != 0;
+	};
+	if (array.elementType == DATA_TYPE_INT) // a stable sort stays within the array even if the comparator is inconsistent
+		std::stable_sort(array.ints.begin(), array.ints.end(), IsBefore);
+	else
+		std::stable_sort(array.floats.begin(), array.floats.end(), IsBefore);
+}
+
+inline int BinarySearch(Variable& values, Variable& value)
+{
+	Array& array = GetArrayArgument(values, "BinarySearch");
+	if (array.elementType == DATA_TYPE_INT)
+		return SearchSortedValues(array.ints, (int)value);
+	return SearchSortedValues(array.floats, (float)value);
+}
+
+inline int Unique(Variable& values)
+{
+	Array& array = GetArrayArgument(values, "Unique");
+	if (array.elementType == DATA_TYPE_INT)
+		array.ints.erase(std::unique(array.ints.begin(), array.ints.end()), array.ints.end());
+	else
+		array.floats.erase(std::unique(array.floats.begin(), array.floats.end()), array.floats.end());
+	return (int)array.Size();
+}
+
+inline std::string SortParts(std::string_view text, std::string_view separator)
+{
+	std::vector<std::string_view> parts = SplitParts(text, separator);
+	std::sort(parts.begin(), parts.end());
+	return JoinParts(parts, separator);
+}
+
+inline std::string UniqueParts(std::string_view text, std::string_view separator)
+{
+	std::vector<std::string_view> parts = SplitParts(text, separator);
+	parts.erase(std::unique(parts.begin(), parts.end()), parts.end());
+	return JoinParts(parts, separator);
+}
+
+inline HashMap& GetMapArgument(const Variable& var, const char* function)
+{
+	if (var.GetMap() == nullptr)
+		throw std::runtime_error(std::string(function) + ": expected a map, got a " + DataTypeToInternalTypeString(var.type));
+	return *var.GetMap();
+}
+
+inline const HashMap::Entry& GetMapEntry(const Variable& values, int index, const char* function)
+{
+	HashMap& map = GetMapArgument(values, function);
+	if (index < 0 || index >= (int)map.Size())
+		throw std::runtime_error(std::string(function) + ": the index " + std::to_string(index) + " is outside of the map, it has " + std::to_string(map.Size()) + " keys");
+	return map.GetEntry(index);
+}
+
+inline bool HasKey(Variable& values, Variable& key)
+{
+	return GetMapArgument(values, "HasKey").Find(key) != nullptr;
+}
+
+inline bool RemoveKey(Variable& values, Variable& key)
+{
+	return GetMapArgument(values, "RemoveKey").Erase(key);
 }
 
-IndexString::IndexString(Function* function) : Function(function)
+inline int KeyCount(Variable& values)
 {
-	name = "IndexString";
-	returnType = DATA_TYPE_STRING_CONSTANT;
+	return (int)GetMapArgument(values, "KeyCount").Size();
 }
 
-void IndexString::Execute()
+inline Variable KeyAt(Variable& values, int index)
 {
-	char ret = ((std::string)*Interpreter::FindVariable("input"))[(int)*Interpreter::FindVariable("index")];
-	Return({ std::string{ ret }, DATA_TYPE_STRING_CONSTANT });
-}
\ No newline at end of file
+	return GetMapEntry(values, index, "KeyAt").key;
+}
+
+inline Variable ValueAt(Variable& values, int index)
+{
+	return GetMapEntry(values, index, "ValueAt").value;
+}
+
+inline void ClearMap(Variable& values)
+{
+	GetMapArgument(values, "ClearMap").Clear();
+}
+
+inline Symbol GetGeneratorFunction(ScriptContext& context, std::string_view function)
+{
+	if (!Parser::DoesFunctionExist(context, function))
+		throw std::runtime_error("Generate: there is no function called " + std::string(function));
+	return SymbolTable::Find(function);
+}
+
+inline int Generate(ScriptContext& context, std::string_view function)
+{
+	return Generators::Start(context, GetGeneratorFunction(context, function), {});
+}
+
+inline int GenerateFrom(ScriptContext& context, std::string_view function, Variable& argument)
+{
+	return Generators::Start(context, GetGeneratorFunction(context, function), { argument });
+}
+
+inline bool HasNext(ScriptContext& context, int generator)
+{
+	return Generators::HasNext(context, generator);
+}
+
+inline Variable Next(ScriptContext& context, int generator)
+{
+	return Generators::Next(context, generator);
+}
+
+inline void StopGenerator(ScriptContext& context, int generator)
+{
+	Generators::Stop(context, generator);
+}
+
+inline int CreateChannelWithCapacity(ScriptContext& context, int capacity, bool isSingleProducer)
+{
+	if (capacity < 1)
+		throw std::runtime_error("CreateChannel: the capacity " + std::to_string(capacity) + " is less than 1");
+	return Channels::Create(context, capacity, isSingleProducer);
+}
+
+inline int CreateChannel(ScriptContext& context, int capacity)
+{
+	return CreateChannelWithCapacity(context, capacity, false);
+}
+
+inline int CreateSingleProducerChannel(ScriptContext& context, int capacity)
+{
+	return CreateChannelWithCapacity(context, capacity, true);
+}
+
+inline void Send(ScriptContext& context, int channel, Variable& value)
+{
+	Channels::Send(context, channel, value);
+}
+
+inline bool TrySend(ScriptContext& context, int channel, Variable& value)
+{
+	return Channels::TrySend(context, channel, value);
+}
+
+inline Variable Receive(ScriptContext& context, int channel)
+{
+	return Channels::Receive(context, channel);
+}
+
+inline Variable TryReceive(ScriptContext& context, int channel, Variable& empty)
+{
+	Variable ret;
+	return Channels::TryReceive(context, channel, ret) ? ret : empty;
+}
+
+inline void CloseChannel(ScriptContext& context, int channel)
+{
+	Channels::Close(context, channel);
+}
+
+// the native functions of every standard file, they are only bound if the file is imported and declares them as extern
+const std::unordered_map<std::string_view, std::vector<NativeFunction>> standardFiles =
+{
+	{ "std/io.script", {
+		Bind("WriteLine", WriteLine),
+		Bind("Write", Write),
+		Bind("Flush", Flush),
+		Bind("GetLine", GetLine),
+		Bind("ReadAll", ReadAll),
+		Bind("IsEndOfInput", IsEndOfInput),
+	} },
+	{ "std/file.script", {
+		Bind("OpenFile", OpenFile),
+		Bind("CreateFile", CreateFileForWriting),
+		Bind("ReadFileLine", ReadFileLine),
+		Bind("ReadFileChunk", ReadFileChunk),
+		Bind("IsEndOfFile", IsEndOfFile),
+		Bind("WriteFile", WriteFile),
+		Bind("CloseFile", CloseFile),
+	} },
+	{ "std/types.script", {
+		Bind("ToString", ToString),
+		Bind("IntToString", IntToString),
+		Bind("ToFloat", ToFloat),
+		Bind("ToInt", ToInt),
+		Bind("SumInts", SumInts),
+		Bind("SumFloats", SumFloats),
+		Bind("ToIntAt", ToIntAt),
+		Bind("ToFloatAt", ToFloatAt),
+	} },
+	{ "std/string.script", {
+		Bind("IndexString", IndexString),
+		Bind("Length", Length),
+		Bind("Substring", Substring),
+		Bind("Find", Find),
+		Bind("StartsWith", StartsWith),
+		Bind("Replace", Replace),
+		Bind("SplitCount", SplitCount),
+		Bind("SplitFrom", SplitFrom),
+	} },
+	{ "std/reflection.script", {
+		Bind("nameof", NameOf),
+		Bind("typeof", TypeOf),
+	} },
+	{ "std/array.script", {
+		Bind("IntArray", IntArray),
+		Bind("FloatArray", FloatArray),
+		Bind("ParseInts", ParseInts),
+		Bind("ParseFloats", ParseFloats),
+		Bind("FormatInts", FormatInts),
+		Bind("FormatFloats", FormatFloats),
+		Bind("Count", Count),
+		Bind("Sum", Sum),
+		Bind("Min", Min),
+		Bind("Max", Max),
+		Bind("Dot", Dot),
+		Bind("Scale", Scale),
+		Bind("Add", Add),
+	} },
+	{ "std/math.script", {
+		Bind("Abs", Abs),
+		Bind("Floor", Floor),
+		Bind("Ceil", Ceil),
+		Bind("Round", Round),
+		Bind("Sqrt", Sqrt),
+		Bind("Pow", Pow),
+		Bind("Exp", Exp),
+		Bind("Log", Log),
+		Bind("Sin", Sin),
+		Bind("Cos", Cos),
+		Bind("Tan", Tan),
+		Bind("Atan2", Atan2),
+		Bind("SqrtAll", SqrtAll),
+		Bind("ExpAll", ExpAll),
+		Bind("Mean", Mean),
+		Bind("Variance", Variance),
+	} },
+	{ "std/sort.script", {
+		Bind("Sort", Sort),
+		Bind("SortBy", SortBy),
+		Bind("BinarySearch", BinarySearch),
+		Bind("Unique", Unique),
+		Bind("SortParts", SortParts),
+		Bind("UniqueParts", UniqueParts),
+	} },
+	{ "std/map.script", {
+		Bind("HasKey", HasKey),
+		Bind("RemoveKey", RemoveKey),
+		Bind("KeyCount", KeyCount),
+		Bind("KeyAt", KeyAt),
+		Bind("ValueAt", ValueAt),
+		Bind("ClearMap", ClearMap),
+	} },
+	{ "std/generator.script", {
+		Bind("Generate", Generate),
+		Bind("GenerateFrom", GenerateFrom),
+		Bind("HasNext", HasNext),
+		Bind("Next", Next),
+		Bind("StopGenerator", StopGenerator),
+	} },
+	{ "std/channel.script", {
+		Bind("CreateChannel", CreateChannel),
+		Bind("CreateSingleProducerChannel", CreateSingleProducerChannel),
+		Bind("Send", Send),
+		Bind("TrySend", TrySend),
+		Bind("Receive", Receive),
+		Bind("TryReceive", TryReceive),
+		Bind("CloseChannel", CloseChannel),
+	} },
+};
+
+void StandardLib::Init(ScriptContext& context)
+{
+	for (const std::string& file : context.importedFiles)
+	{
+		auto natives = standardFiles.find(file);
+		if (natives == standardFiles.end())
+			continue;
+		for (const NativeFunction& function : natives->second)
+			if (Parser::DoesFunctionExist(context, function.name))
+				Interpreter::SetNativeFunction(context, SymbolTable::Intern(function.name), function);
+	}
+}